@@ -30,6 +30,7 @@ import com.nativeapptemplate.nativeapptemplatefree.ui.app_root.NatApp
 import com.nativeapptemplate.nativeapptemplatefree.ui.app_root.rememberNatAppState
 import com.nativeapptemplate.nativeapptemplatefree.utils.NetworkMonitor
 import com.nativeapptemplate.nativeapptemplatefree.utils.Utility
+import com.ovidiucristurean.shared.analytics.presentation.AnalyticsTracker
 import kotlinx.coroutines.launch
 import org.koin.android.ext.android.inject
 import org.koin.androidx.viewmodel.ext.android.viewModel
@@ -38,6 +39,7 @@ import java.util.Date
 class MainActivity : ComponentActivity() {
   val networkMonitor: NetworkMonitor by inject()
   val loginRepository: LoginRepository by inject()
+  private val analyticsTracker: AnalyticsTracker by inject()
 
   private val viewModel: MainActivityViewModel by viewModel()
   var uiState: MainActivityUiState by mutableStateOf(Loading)
@@ -172,6 +174,13 @@ class MainActivity : ComponentActivity() {
     viewModel.updatePermissions()
   }
 
+  override fun onStop() {
+    super.onStop()
+    lifecycleScope.launch {
+      analyticsTracker.flush()
+    }
+  }
+
   private fun updateItemTagInfoFromNdefMessage(itemTagInfoFromNdefMessage: ItemTagInfoFromNdefMessage) {
     if (itemTagInfoFromNdefMessage.success) {
       itemTagInfoFromNdefMessage.scannedAt = Date().toInstant().toString()
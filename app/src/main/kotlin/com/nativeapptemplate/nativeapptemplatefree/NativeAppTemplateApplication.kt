@@ -3,6 +3,7 @@ package com.nativeapptemplate.nativeapptemplatefree
 import android.app.Application
 import com.nativeapptemplate.nativeapptemplatefree.di.appModule
 import com.nativeapptemplate.nativeapptemplatefree.utils.ProfileVerifierLogger
+import com.ovidiucristurean.shared.analytics.data.retention.scheduleVisitRetention
 import com.ovidiucristurean.shared.di.initKoin
 import org.koin.android.ext.android.inject
 import org.koin.android.ext.koin.androidContext
@@ -19,6 +20,7 @@ class NativeAppTemplateApplication : Application() {
       androidContext(this@NativeAppTemplateApplication)
       modules(appModule)
     }
+    scheduleVisitRetention(this)
     
     profileVerifierLogger()
   }
@@ -10,6 +10,8 @@ import com.nativeapptemplate.nativeapptemplatefree.testing.repository.TestShopRe
 import com.nativeapptemplate.nativeapptemplatefree.testing.util.MainDispatcherRule
 import com.nativeapptemplate.nativeapptemplatefree.ui.shop_settings.navigation.ShopSettingsRoute
 import com.ovidiucristurean.shared.analytics.presentation.AnalyticsTracker
+import com.ovidiucristurean.shared.analytics.presentation.AnalyticsTrackerStats
+import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.collect
 import kotlinx.coroutines.flow.first
 import kotlinx.coroutines.launch
@@ -85,16 +87,25 @@ class ShopSettingsViewModelTest {
     viewModel.reload()
 
     assertEquals(testInputShop.datum!!.id, analyticsTracker.trackedShopId)
+    assertNull(analyticsTracker.trackedVisitorKey)
   }
 }
 
 class TestAnalyticsTracker : AnalyticsTracker {
+  override val stats = MutableStateFlow(AnalyticsTrackerStats())
+
   var trackedShopId: String? = null
     private set
 
-  override fun trackVisit(shopId: String) {
+  var trackedVisitorKey: String? = null
+    private set
+
+  override fun trackVisit(shopId: String, visitorKey: String?) {
     trackedShopId = shopId
+    trackedVisitorKey = visitorKey
   }
+
+  override suspend fun flush() = Unit
 }
 
 private const val SHOP_TYPE = "shop"
@@ -26,4 +26,6 @@ plugins {
   alias(libs.plugins.kotlin.multiplatform) apply false
   alias(libs.plugins.android.kotlin.multiplatform.library) apply false
   alias(libs.plugins.android.lint) apply false
+  alias(libs.plugins.kotlin.allopen) apply false
+  alias(libs.plugins.kotlinx.benchmark) apply false
 }
@@ -8,6 +8,8 @@ plugins {
   alias(libs.plugins.ksp)
   alias(libs.plugins.room)
   alias(libs.plugins.skie)
+  alias(libs.plugins.kotlin.allopen)
+  alias(libs.plugins.kotlinx.benchmark)
 }
 
 kotlin {
@@ -18,6 +20,7 @@ kotlin {
   }
 
   configureXCFramework()
+  configureBenchmarkTargets()
 
   sourceSets {
     commonMain {
@@ -25,17 +28,39 @@ kotlin {
         api(libs.kotlinx.datetime)
         implementation(libs.kotlinx.coroutines.core)
         implementation(libs.androidx.room.runtime)
-        implementation(libs.uuid)
         api(libs.koin.core)
         implementation(libs.androidx.sqlite.bundled)
+        implementation(libs.okio)
+      }
+    }
+    androidMain {
+      dependencies {
+        implementation(libs.androidx.work.runtime.ktx)
       }
     }
     commonTest {
       dependencies {
         implementation(libs.kotlin.test)
         implementation(libs.kotlinx.coroutines.test)
+        implementation(libs.okio.fakefilesystem)
+      }
+    }
+    jvmTest {
+      dependencies {
+        implementation(libs.androidx.room.testing)
+      }
+    }
+    val commonBenchmark by creating {
+      dependencies {
+        implementation(libs.kotlinx.benchmark.runtime)
+        implementation(libs.kotlinx.coroutines.core)
+        implementation(libs.androidx.room.runtime)
+        implementation(libs.androidx.sqlite.bundled)
+        implementation(libs.okio)
       }
     }
+    getByName("jvmBenchmark").dependsOn(commonBenchmark)
+    getByName("linuxX64Benchmark").dependsOn(commonBenchmark)
   }
 }
 
@@ -44,12 +69,70 @@ dependencies {
   add("kspIosSimulatorArm64", libs.androidx.room.compiler)
   add("kspIosX64", libs.androidx.room.compiler)
   add("kspIosArm64", libs.androidx.room.compiler)
+  add("kspJvm", libs.androidx.room.compiler)
+  add("kspLinuxX64", libs.androidx.room.compiler)
 }
 
 room {
   schemaDirectory("$projectDir/schemas")
 }
 
+// JMH needs the @State classes to be open.
+allOpen {
+  annotation("org.openjdk.jmh.annotations.State")
+}
+
+// Run with `./gradlew :shared:benchmark`. Reports are written as JSON under
+// build/reports/benchmarks, one directory per run, so two releases can be diffed.
+benchmark {
+  targets {
+    register("jvmBenchmark")
+    register("linuxX64Benchmark")
+  }
+  configurations {
+    named("main") {
+      warmups = 3
+      iterations = 5
+      iterationTime = 1
+      iterationTimeUnit = "s"
+      reportFormat = "json"
+    }
+    // A single short pass over every case, to check that the suite still runs.
+    register("smoke") {
+      warmups = 1
+      iterations = 1
+      iterationTime = 200
+      iterationTimeUnit = "ms"
+      reportFormat = "json"
+      param("eventCount", 10000)
+    }
+  }
+}
+
+// The benchmarks and the Room tests run on the JVM and on Linux, where Room works with the bundled
+// SQLite driver. These two targets are for the host only: the apps consume the Android variant
+// and the XCFramework, and the benchmark code lives in its own compilations. If the module is
+// ever published, the host targets are left out.
+private fun KotlinMultiplatformExtension.configureBenchmarkTargets() {
+  listOf(
+    jvm(),
+    linuxX64(),
+  ).forEach { target ->
+    target.compilations.create("benchmark") {
+      associateWith(target.compilations.getByName("main"))
+    }
+  }
+  // The JVM tests also cover the stream generator and replay driver the benchmarks rely on.
+  jvm().compilations.getByName("test")
+    .associateWith(jvm().compilations.getByName("benchmark"))
+}
+
+plugins.withId("maven-publish") {
+  tasks.withType<AbstractPublishToMaven>().configureEach {
+    onlyIf { publication.name !in setOf("jvm", "linuxX64") }
+  }
+}
+
 private fun KotlinMultiplatformExtension.configureXCFramework() {
   val xcFrameworkName = "analyticsKit"
   val xcf = XCFramework(xcFrameworkName)
@@ -3,6 +3,8 @@ package com.ovidiucristurean.shared.analytics.data.local.database
 import android.content.Context
 import androidx.room.Room
 import androidx.room.RoomDatabase
+import okio.Path
+import okio.Path.Companion.toOkioPath
 
 fun getAnalyticsDatabaseBuilder(context: Context): RoomDatabase.Builder<AnalyticsDatabase> {
     val dbFile = context.getDatabasePath("analytics.db")
@@ -11,3 +13,6 @@ fun getAnalyticsDatabaseBuilder(context: Context): RoomDatabase.Builder<Analytic
         name = dbFile.absolutePath
     )
 }
+
+fun getAnalyticsJournalDirectory(context: Context): Path =
+    context.filesDir.toOkioPath() / "analytics-journal"
@@ -0,0 +1,50 @@
+package com.ovidiucristurean.shared.analytics.data.retention
+
+import android.content.Context
+import androidx.work.Constraints
+import androidx.work.CoroutineWorker
+import androidx.work.ExistingPeriodicWorkPolicy
+import androidx.work.PeriodicWorkRequestBuilder
+import androidx.work.WorkManager
+import androidx.work.WorkerParameters
+import com.ovidiucristurean.shared.analytics.logMessage
+import org.koin.core.component.KoinComponent
+import org.koin.core.component.inject
+import java.util.concurrent.TimeUnit
+
+/**
+ * Runs the [VisitRetentionEngine] from Koin in the background. Scheduled by
+ * [scheduleVisitRetention].
+ */
+class VisitRetentionWorker(
+    context: Context,
+    params: WorkerParameters
+) : CoroutineWorker(context, params), KoinComponent {
+    private val retentionEngine: VisitRetentionEngine by inject()
+
+    override suspend fun doWork(): Result {
+        val report = retentionEngine.run()
+        logMessage(
+            "Purged ${report.deletedVisits} raw visits before ${report.rawHorizon}, " +
+                "freed ${report.freedPages} pages"
+        )
+        return Result.success()
+    }
+}
+
+/**
+ * Runs [VisitRetentionWorker] about once a day while the battery is not low. Call it after Koin
+ * is started, on every app start: an already scheduled run is kept.
+ */
+fun scheduleVisitRetention(context: Context) {
+    val request = PeriodicWorkRequestBuilder<VisitRetentionWorker>(1, TimeUnit.DAYS)
+        .setConstraints(Constraints.Builder().setRequiresBatteryNotLow(true).build())
+        .build()
+    WorkManager.getInstance(context).enqueueUniquePeriodicWork(
+        VISIT_RETENTION_WORK,
+        ExistingPeriodicWorkPolicy.KEEP,
+        request
+    )
+}
+
+private const val VISIT_RETENTION_WORK = "visit-retention"
@@ -1,14 +1,24 @@
 package com.ovidiucristurean.shared.di
 
-import androidx.sqlite.driver.bundled.BundledSQLiteDriver
+import com.ovidiucristurean.shared.analytics.data.journal.VisitJournal
+import com.ovidiucristurean.shared.analytics.data.local.database.ANALYTICS_MIGRATIONS
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsStorageProfile
 import com.ovidiucristurean.shared.analytics.data.local.database.getAnalyticsDatabaseBuilder
+import com.ovidiucristurean.shared.analytics.data.local.database.getAnalyticsJournalDirectory
+import com.ovidiucristurean.shared.analytics.data.local.database.setStorageProfile
+import kotlinx.coroutines.CoroutineDispatcher
 import kotlinx.coroutines.Dispatchers
+import okio.FileSystem
 import org.koin.core.module.Module
+import org.koin.core.qualifier.named
 import org.koin.dsl.module
 
 actual fun platformModule(): Module = module {
     single { getAnalyticsDatabaseBuilder(get())
-      .setDriver(BundledSQLiteDriver())
+      .setStorageProfile(AnalyticsStorageProfile.READ_HEAVY)
+      .addMigrations(*ANALYTICS_MIGRATIONS)
       .setQueryCoroutineContext(Dispatchers.IO)
       .build() }
+    single { VisitJournal(FileSystem.SYSTEM, getAnalyticsJournalDirectory(get())) }
+    single<CoroutineDispatcher>(named(ANALYTICS_IO_DISPATCHER)) { Dispatchers.IO }
 }
@@ -0,0 +1,93 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.data.journal.VisitJournal
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsDatabase
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsStorageProfile
+import com.ovidiucristurean.shared.analytics.data.repository.ColumnarAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.data.repository.InMemoryAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.data.repository.JournaledAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.data.repository.RoomAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.cancel
+import kotlinx.datetime.Instant
+import okio.FileSystem
+import okio.Path
+import kotlin.time.Duration.Companion.days
+
+internal const val MEMORY_REPOSITORY = "memory"
+internal const val COLUMNAR_REPOSITORY = "columnar"
+internal const val ROOM_REPOSITORY = "room"
+internal const val JOURNAL_REPOSITORY = "journal"
+
+internal val BENCHMARK_START = Instant.parse("2024-01-01T00:00:00Z")
+internal val BENCHMARK_SPAN = 60.days
+internal const val BENCHMARK_SHOP_COUNT = 10
+
+/**
+ * A fresh, file-backed [AnalyticsDatabase] with the same driver and migrations as the app, tuned
+ * with [profile], and an empty directory for a visit journal. [close] closes the database and
+ * deletes all its files.
+ */
+internal expect fun createBenchmarkDatabase(
+    profile: AnalyticsStorageProfile = AnalyticsStorageProfile.READ_HEAVY
+): BenchmarkDatabase
+
+internal class BenchmarkDatabase(
+    val database: AnalyticsDatabase,
+    val journalDirectory: Path,
+    private val deleteFiles: () -> Unit
+) {
+    fun close() {
+        database.close()
+        FileSystem.SYSTEM.deleteRecursively(journalDirectory)
+        deleteFiles()
+    }
+}
+
+internal class BenchmarkRepository(
+    type: String,
+    profile: AnalyticsStorageProfile = AnalyticsStorageProfile.READ_HEAVY
+) {
+    private val database = when (type) {
+        MEMORY_REPOSITORY, COLUMNAR_REPOSITORY -> null
+        ROOM_REPOSITORY, JOURNAL_REPOSITORY -> createBenchmarkDatabase(profile)
+        else -> throw IllegalArgumentException("Unknown repository: $type")
+    }
+    private val scope = CoroutineScope(SupervisorJob() + Dispatchers.Default)
+
+    val repository: AnalyticsRepository = when {
+        type == COLUMNAR_REPOSITORY -> ColumnarAnalyticsRepository()
+        database == null -> InMemoryAnalyticsRepository()
+        type == JOURNAL_REPOSITORY -> JournaledAnalyticsRepository(
+            room = RoomAnalyticsRepository(database.database),
+            journal = VisitJournal(FileSystem.SYSTEM, database.journalDirectory),
+            scope = scope,
+            ioDispatcher = Dispatchers.Default
+        )
+        else -> RoomAnalyticsRepository(database.database)
+    }
+
+    fun close() {
+        scope.cancel()
+        database?.close()
+    }
+}
+
+internal fun benchmarkShopId(index: Int) = "shop-${index % BENCHMARK_SHOP_COUNT}"
+
+/**
+ * Records [eventCount] visits spread evenly over [BENCHMARK_SPAN], round-robin over
+ * [BENCHMARK_SHOP_COUNT] shops, in batches like the tracker commits them.
+ */
+internal suspend fun AnalyticsRepository.seed(eventCount: Int) {
+    val step = BENCHMARK_SPAN / eventCount
+    (0 until eventCount).chunked(SEED_BATCH_SIZE).forEach { indices ->
+        recordVisits(indices.map { VisitEvent(benchmarkShopId(it), BENCHMARK_START + step * it) })
+    }
+}
+
+private const val SEED_BATCH_SIZE = 10_000
@@ -0,0 +1,108 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import androidx.sqlite.SQLiteConnection
+import androidx.sqlite.driver.bundled.BundledSQLiteDriver
+import androidx.sqlite.execSQL
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import okio.FileSystem
+import okio.Path.Companion.toPath
+import kotlin.random.Random
+import kotlin.uuid.ExperimentalUuidApi
+import kotlin.uuid.Uuid
+
+/**
+ * Primary keys `visit_events` has had: a random UUID string up to version 2 and an auto-increment
+ * INTEGER rowid since version 3.
+ */
+internal enum class VisitKey(val columnSql: String) {
+    UUID("`id` TEXT NOT NULL PRIMARY KEY"),
+    INTEGER("`id` INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL");
+
+    companion object {
+        fun named(name: String): VisitKey = valueOf(name.uppercase())
+    }
+}
+
+/**
+ * A bare `visit_events` table on its own bundled SQLite connection, for comparing table layouts
+ * that Room no longer creates. [key] picks the primary key and [indexed] whether the
+ * (shopId, timestampEpochMillis) index exists. [close] deletes the database files.
+ */
+internal class RawVisitTable(
+    private val key: VisitKey,
+    indexed: Boolean = true
+) : AutoCloseable {
+    private val path = FileSystem.SYSTEM_TEMPORARY_DIRECTORY /
+        "visit-table-${Random.nextLong().toULong()}.db"
+    private val connection: SQLiteConnection = BundledSQLiteDriver().open(path.toString())
+
+    init {
+        connection.execSQL(
+            "CREATE TABLE `visit_events` (${key.columnSql}, " +
+                "`shopId` TEXT NOT NULL, " +
+                "`timestampEpochMillis` INTEGER NOT NULL)"
+        )
+        if (indexed) {
+            connection.execSQL(
+                "CREATE INDEX `index_visit_events_shopId_timestampEpochMillis` " +
+                    "ON `visit_events` (`shopId`, `timestampEpochMillis`)"
+            )
+        }
+    }
+
+    /**
+     * Inserts [events] in one transaction through one prepared statement, as Room's insertAll
+     * does. Under [VisitKey.UUID] each row gets a fresh random key, as recordVisit used to.
+     */
+    @OptIn(ExperimentalUuidApi::class)
+    fun insert(events: List<VisitEvent>) {
+        val sql = when (key) {
+            VisitKey.UUID -> "INSERT INTO `visit_events` VALUES (?, ?, ?)"
+            VisitKey.INTEGER ->
+                "INSERT INTO `visit_events` (`shopId`, `timestampEpochMillis`) VALUES (?, ?)"
+        }
+        connection.execSQL("BEGIN IMMEDIATE")
+        connection.prepare(sql).use { statement ->
+            events.forEach { event ->
+                var column = 1
+                if (key == VisitKey.UUID) statement.bindText(column++, Uuid.random().toString())
+                statement.bindText(column++, event.shopId)
+                statement.bindLong(column, event.timestamp.toEpochMilliseconds())
+                statement.step()
+                statement.reset()
+            }
+        }
+        connection.execSQL("COMMIT")
+    }
+
+    /**
+     * Visits of [shopId] in [fromMillis, toMillis], the range countVisits has queried since
+     * version 1.
+     */
+    fun countVisits(shopId: String, fromMillis: Long, toMillis: Long): Long =
+        connection.prepare(
+            "SELECT COUNT(*) FROM `visit_events` WHERE `shopId` = ? " +
+                "AND `timestampEpochMillis` BETWEEN ? AND ?"
+        ).use { statement ->
+            statement.bindText(1, shopId)
+            statement.bindLong(2, fromMillis)
+            statement.bindLong(3, toMillis)
+            if (statement.step()) statement.getLong(0) else 0L
+        }
+
+    /**
+     * Bytes the database file takes, table and indices together.
+     */
+    fun sizeBytes(): Long = queryLong("PRAGMA page_count") * queryLong("PRAGMA page_size")
+
+    private fun queryLong(sql: String): Long = connection.prepare(sql).use { statement ->
+        if (statement.step()) statement.getLong(0) else 0L
+    }
+
+    override fun close() {
+        connection.close()
+        listOf("", "-wal", "-shm", "-journal").forEach {
+            FileSystem.SYSTEM.delete("$path$it".toPath(), mustExist = false)
+        }
+    }
+}
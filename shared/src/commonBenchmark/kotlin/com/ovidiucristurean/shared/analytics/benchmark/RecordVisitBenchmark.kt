@@ -0,0 +1,54 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import com.ovidiucristurean.shared.analytics.domain.usecase.RecordVisitUseCase
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.Param
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.Setup
+import kotlinx.benchmark.State
+import kotlinx.benchmark.TearDown
+import kotlinx.coroutines.runBlocking
+import kotlin.time.Duration.Companion.milliseconds
+
+/**
+ * Throughput of [RecordVisitUseCase], one operation being one committed batch of [batchSize]
+ * visits. A batch of 1 is what every scan cost before the tracker batched writes. The journal
+ * case measures the synced append; its drainer runs in the background as it does in the app.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.Throughput)
+class RecordVisitBenchmark {
+    @Param(MEMORY_REPOSITORY, ROOM_REPOSITORY, JOURNAL_REPOSITORY)
+    var repositoryType = ""
+
+    @Param("1", "256")
+    var batchSize = 0
+
+    private lateinit var benchmarkRepository: BenchmarkRepository
+    private lateinit var recordVisit: RecordVisitUseCase
+    private var nextVisit = 0
+
+    @Setup
+    fun setUp() {
+        benchmarkRepository = BenchmarkRepository(repositoryType)
+        recordVisit = RecordVisitUseCase(benchmarkRepository.repository)
+    }
+
+    @TearDown
+    fun tearDown() {
+        benchmarkRepository.close()
+    }
+
+    @Benchmark
+    fun recordBatch() = runBlocking {
+        recordVisit(
+            List(batchSize) {
+                val visit = nextVisit++
+                VisitEvent(benchmarkShopId(visit), BENCHMARK_START + visit.milliseconds)
+            }
+        )
+    }
+}
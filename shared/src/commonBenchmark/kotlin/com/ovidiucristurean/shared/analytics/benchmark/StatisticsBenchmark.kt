@@ -0,0 +1,86 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.domain.model.ShopStatistics
+import com.ovidiucristurean.shared.analytics.domain.model.TrendPeriod
+import com.ovidiucristurean.shared.analytics.domain.model.VisitTrend
+import com.ovidiucristurean.shared.analytics.domain.model.WeeklyTrend
+import com.ovidiucristurean.shared.analytics.domain.usecase.GetShopStatisticsUseCase
+import com.ovidiucristurean.shared.analytics.domain.usecase.GetVisitTrendUseCase
+import com.ovidiucristurean.shared.analytics.domain.usecase.GetWeeklyTrendUseCase
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.BenchmarkTimeUnit
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.OutputTimeUnit
+import kotlinx.benchmark.Param
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.Setup
+import kotlinx.benchmark.State
+import kotlinx.benchmark.TearDown
+import kotlinx.coroutines.runBlocking
+import kotlinx.datetime.TimeZone
+import kotlin.time.Duration.Companion.days
+import kotlin.time.Duration.Companion.hours
+
+/**
+ * Latency of the dashboard queries over a store seeded with [eventCount] visits spread over
+ * [BENCHMARK_SPAN] and [BENCHMARK_SHOP_COUNT] shops. The queried window is the last 30 days.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(BenchmarkTimeUnit.MICROSECONDS)
+class StatisticsBenchmark {
+    @Param(MEMORY_REPOSITORY, COLUMNAR_REPOSITORY, ROOM_REPOSITORY)
+    var repositoryType = ""
+
+    @Param("10000", "100000", "1000000")
+    var eventCount = 0
+
+    private lateinit var benchmarkRepository: BenchmarkRepository
+    private lateinit var cachedShopStatistics: GetShopStatisticsUseCase
+    private lateinit var weeklyTrend: GetWeeklyTrendUseCase
+    private lateinit var visitTrend: GetVisitTrendUseCase
+
+    private val shopId = benchmarkShopId(0)
+    private val to = BENCHMARK_START + BENCHMARK_SPAN
+    private val from = to - 30.days
+    // Off the day boundary, so the rollup path also reads partial days from raw rows.
+    private val now = to - 5.hours
+
+    @Setup
+    fun setUp() = runBlocking {
+        benchmarkRepository = BenchmarkRepository(repositoryType)
+        benchmarkRepository.repository.seed(eventCount)
+        cachedShopStatistics = GetShopStatisticsUseCase(benchmarkRepository.repository)
+        weeklyTrend = GetWeeklyTrendUseCase(benchmarkRepository.repository)
+        visitTrend = GetVisitTrendUseCase(benchmarkRepository.repository)
+    }
+
+    @TearDown
+    fun tearDown() {
+        benchmarkRepository.close()
+    }
+
+    // A fresh use case has nothing cached, so this is a full computation every time.
+    @Benchmark
+    fun shopStatistics(): ShopStatistics = runBlocking {
+        GetShopStatisticsUseCase(benchmarkRepository.repository)(shopId, from, to, TimeZone.UTC)
+    }
+
+    // The same window again, as a dashboard refresh asks for it.
+    @Benchmark
+    fun shopStatisticsRefresh(): ShopStatistics = runBlocking {
+        cachedShopStatistics(shopId, from, to, TimeZone.UTC)
+    }
+
+    @Benchmark
+    fun weeklyTrend(): WeeklyTrend = runBlocking {
+        weeklyTrend(shopId, now, TimeZone.UTC)
+    }
+
+    // Every boundary cuts a day in two, so this is the most raw reads the rollup path makes.
+    @Benchmark
+    fun dailyTrend(): VisitTrend = runBlocking {
+        visitTrend(shopId, now, TrendPeriod.DAY, periodCount = 12, TimeZone.UTC)
+    }
+}
@@ -0,0 +1,93 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsStorageProfile
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.BenchmarkTimeUnit
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.OutputTimeUnit
+import kotlinx.benchmark.Param
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.Setup
+import kotlinx.benchmark.State
+import kotlinx.benchmark.TearDown
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.runBlocking
+import kotlinx.datetime.TimeZone
+import kotlin.time.Duration.Companion.days
+import kotlin.time.Duration.Companion.milliseconds
+
+/**
+ * Mixed read/write throughput of Room under each [AnalyticsStorageProfile]. One operation is a
+ * round in which a writer commits [WRITE_BATCHES] tracker-sized batches while [READERS] dashboards
+ * each run [READS_PER_READER] queries, all at the same time, over [eventCount] seeded visits.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(BenchmarkTimeUnit.SECONDS)
+class StorageProfileBenchmark {
+    @Param("write-heavy", "read-heavy", "low-memory")
+    var profileName = ""
+
+    @Param("100000")
+    var eventCount = 0
+
+    private lateinit var benchmarkRepository: BenchmarkRepository
+    private var nextVisit = 0L
+
+    private val to = BENCHMARK_START + BENCHMARK_SPAN
+    private val from = to - 30.days
+
+    @Setup
+    fun setUp() = runBlocking {
+        benchmarkRepository = BenchmarkRepository(
+            ROOM_REPOSITORY,
+            AnalyticsStorageProfile.named(profileName)
+        )
+        benchmarkRepository.repository.seed(eventCount)
+    }
+
+    @TearDown
+    fun tearDown() {
+        benchmarkRepository.close()
+    }
+
+    @Benchmark
+    fun mixedReadWrite() = runBlocking(Dispatchers.Default) {
+        val repository = benchmarkRepository.repository
+        coroutineScope {
+            launch {
+                repeat(WRITE_BATCHES) {
+                    repository.recordVisits(List(WRITE_BATCH_SIZE) { nextVisitEvent() })
+                }
+            }
+            repeat(READERS) { reader ->
+                launch {
+                    val shopId = benchmarkShopId(reader)
+                    repeat(READS_PER_READER) {
+                        repository.getDailyVisitCounts(shopId, from, to, TimeZone.UTC)
+                    }
+                }
+            }
+        }
+    }
+
+    // Only the writer calls this, so the counter needs no synchronization.
+    private fun nextVisitEvent(): VisitEvent {
+        val index = nextVisit++
+        return VisitEvent(
+            shopId = benchmarkShopId(index.toInt()),
+            timestamp = BENCHMARK_START + (index % BENCHMARK_SPAN.inWholeMilliseconds).milliseconds
+        )
+    }
+
+    private companion object {
+        const val WRITE_BATCHES = 8
+        const val WRITE_BATCH_SIZE = 256
+        const val READERS = 4
+        const val READS_PER_READER = 8
+    }
+}
@@ -0,0 +1,115 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.usecase.RecordVisitUseCase
+import com.ovidiucristurean.shared.analytics.presentation.DefaultAnalyticsTracker
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.delay
+import kotlinx.datetime.Clock
+import kotlinx.datetime.Instant
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.milliseconds
+import kotlin.time.Duration.Companion.nanoseconds
+import kotlin.time.Duration.Companion.seconds
+import kotlin.time.DurationUnit
+import kotlin.time.TimeSource
+
+data class ReplayReport(
+    val tracked: Int,
+    val committed: Int,
+    val eventsPerSecond: Double,
+    val p50Latency: Duration,
+    val p99Latency: Duration
+)
+
+/**
+ * Pushes [events] through a [DefaultAnalyticsTracker] at [eventsPerSecond], or as fast as
+ * possible when it is 0, and measures the time from `trackVisit` until the batch holding the
+ * visit was committed. [events] must have strictly increasing timestamps, as
+ * [VisitStreamGenerator] produces them.
+ */
+class TrackerReplay(
+    private val events: List<VisitEvent>,
+    private val eventsPerSecond: Double
+) {
+    private val timestamps = events.map { it.timestamp.toEpochMilliseconds() }
+
+    suspend fun run(repository: AnalyticsRepository): ReplayReport {
+        val start = TimeSource.Monotonic.markNow()
+        // Written before the channel send and read after the receive, which orders the accesses.
+        val trackedAtNanos = LongArray(events.size)
+        val latencyNanos = LongArray(events.size) { -1L }
+        val clock = ReplayClock()
+        val scope = CoroutineScope(SupervisorJob() + Dispatchers.Default)
+
+        val tracker = DefaultAnalyticsTracker(
+            recordVisit = RecordVisitUseCase(
+                CommitTimingRepository(repository) { committed ->
+                    val committedAt = start.elapsedNow().inWholeNanoseconds
+                    committed.forEach { event ->
+                        val index = timestamps.binarySearch(event.timestamp.toEpochMilliseconds())
+                        latencyNanos[index] = committedAt - trackedAtNanos[index]
+                    }
+                }
+            ),
+            scope = scope,
+            clock = clock
+        )
+
+        try {
+            events.forEachIndexed { index, event ->
+                if (eventsPerSecond > 0) {
+                    val ahead = (index / eventsPerSecond).seconds - start.elapsedNow()
+                    if (ahead > PACING_GRANULARITY) delay(ahead)
+                }
+                clock.next = event.timestamp
+                trackedAtNanos[index] = start.elapsedNow().inWholeNanoseconds
+                tracker.trackVisit(event.shopId)
+            }
+            tracker.flush()
+        } finally {
+            scope.cancel()
+        }
+
+        val elapsed = start.elapsedNow()
+        val latencies = latencyNanos.filter { it >= 0 }.sorted()
+        return ReplayReport(
+            tracked = events.size,
+            committed = latencies.size,
+            eventsPerSecond = latencies.size / elapsed.toDouble(DurationUnit.SECONDS),
+            p50Latency = latencies.percentile(0.50),
+            p99Latency = latencies.percentile(0.99)
+        )
+    }
+
+    private fun List<Long>.percentile(fraction: Double): Duration =
+        if (isEmpty()) Duration.ZERO else this[((size - 1) * fraction).toInt()].nanoseconds
+
+    // Stamps each tracked visit with the replayed timestamp instead of the wall clock.
+    private class ReplayClock : Clock {
+        var next: Instant = Instant.DISTANT_PAST
+
+        override fun now(): Instant = next
+    }
+
+    private companion object {
+        val PACING_GRANULARITY = 1.milliseconds
+    }
+}
+
+/**
+ * Reports every batch to [onCommitted] once [delegate] has stored it.
+ */
+class CommitTimingRepository(
+    private val delegate: AnalyticsRepository,
+    private val onCommitted: (List<VisitEvent>) -> Unit
+) : AnalyticsRepository by delegate {
+    override suspend fun recordVisits(events: List<VisitEvent>) {
+        delegate.recordVisits(events)
+        onCommitted(events)
+    }
+}
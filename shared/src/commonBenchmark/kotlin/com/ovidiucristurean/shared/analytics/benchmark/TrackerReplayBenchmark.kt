@@ -0,0 +1,57 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.BenchmarkTimeUnit
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.OutputTimeUnit
+import kotlinx.benchmark.Param
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.Setup
+import kotlinx.benchmark.State
+import kotlinx.benchmark.TearDown
+import kotlinx.coroutines.runBlocking
+
+/**
+ * Replays a seeded [VisitStreamGenerator] stream through the tracker. The score is the time per
+ * replay, and each replay returns its [ReplayReport] with the achieved rate and enqueue-to-commit
+ * latency percentiles. A [eventsPerSecond] of 0 replays as fast as possible.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(BenchmarkTimeUnit.MILLISECONDS)
+class TrackerReplayBenchmark {
+    @Param(MEMORY_REPOSITORY, ROOM_REPOSITORY)
+    var repositoryType = ""
+
+    @Param("0", "20000")
+    var eventsPerSecond = 0
+
+    private lateinit var benchmarkRepository: BenchmarkRepository
+    private lateinit var replay: TrackerReplay
+
+    @Setup
+    fun setUp() {
+        benchmarkRepository = BenchmarkRepository(repositoryType)
+        val events = VisitStreamGenerator(seed = REPLAY_SEED)
+            .generate(BENCHMARK_START)
+            .take(REPLAY_EVENTS)
+            .toList()
+        replay = TrackerReplay(events, eventsPerSecond.toDouble())
+    }
+
+    @TearDown
+    fun tearDown() {
+        benchmarkRepository.close()
+    }
+
+    @Benchmark
+    fun replay(): ReplayReport = runBlocking {
+        replay.run(benchmarkRepository.repository)
+    }
+
+    private companion object {
+        const val REPLAY_SEED = 42L
+        const val REPLAY_EVENTS = 20_000
+    }
+}
@@ -0,0 +1,60 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.BenchmarkTimeUnit
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.OutputTimeUnit
+import kotlinx.benchmark.Param
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.Setup
+import kotlinx.benchmark.State
+import kotlinx.benchmark.TearDown
+import kotlin.time.Duration.Companion.days
+
+/**
+ * Latency of the one-shop, one-day range count on `visit_events` before and after the
+ * (shopId, timestampEpochMillis) index added in version 2, over [eventCount] visits spread over
+ * [BENCHMARK_SPAN] and [BENCHMARK_SHOP_COUNT] shops. Without the index every query scans the
+ * whole table.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(BenchmarkTimeUnit.MICROSECONDS)
+class VisitIndexBenchmark {
+    @Param("false", "true")
+    var indexed = ""
+
+    @Param("1000000")
+    var eventCount = 0
+
+    private lateinit var table: RawVisitTable
+
+    private val shopId = benchmarkShopId(0)
+    private val to = (BENCHMARK_START + BENCHMARK_SPAN).toEpochMilliseconds()
+    private val from = to - 1.days.inWholeMilliseconds
+
+    @Setup
+    fun setUp() {
+        table = RawVisitTable(VisitKey.INTEGER, indexed = indexed.toBooleanStrict())
+        val step = BENCHMARK_SPAN / eventCount
+        (0 until eventCount).chunked(SEED_BATCH_SIZE).forEach { indices ->
+            table.insert(
+                indices.map { VisitEvent(benchmarkShopId(it), BENCHMARK_START + step * it) }
+            )
+        }
+    }
+
+    @TearDown
+    fun tearDown() {
+        table.close()
+    }
+
+    @Benchmark
+    fun countVisitsInOneDay(): Long = table.countVisits(shopId, from, to)
+
+    private companion object {
+        const val SEED_BATCH_SIZE = 10_000
+    }
+}
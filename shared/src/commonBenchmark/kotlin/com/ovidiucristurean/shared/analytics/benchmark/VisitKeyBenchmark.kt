@@ -0,0 +1,56 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.Param
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.Setup
+import kotlinx.benchmark.State
+import kotlinx.benchmark.TearDown
+import kotlin.time.Duration.Companion.milliseconds
+
+/**
+ * Insert throughput of `visit_events` under each [VisitKey], one operation being one committed
+ * batch of [BATCH_SIZE] visits into a table already holding [eventCount]. Random UUID keys land
+ * all over their B-tree, so their cost grows with the table; rowids always append. The on-disk
+ * size of both layouts is compared in `VisitKeyStorageTest`.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.Throughput)
+class VisitKeyBenchmark {
+    @Param("uuid", "integer")
+    var keyType = ""
+
+    @Param("100000")
+    var eventCount = 0
+
+    private lateinit var table: RawVisitTable
+    private var nextVisit = 0
+
+    @Setup
+    fun setUp() {
+        table = RawVisitTable(VisitKey.named(keyType))
+        repeat(eventCount / BATCH_SIZE) { insertBatch() }
+    }
+
+    @TearDown
+    fun tearDown() {
+        table.close()
+    }
+
+    @Benchmark
+    fun insertBatch() {
+        table.insert(
+            List(BATCH_SIZE) {
+                val visit = nextVisit++
+                VisitEvent(benchmarkShopId(visit), BENCHMARK_START + visit.milliseconds)
+            }
+        )
+    }
+
+    private companion object {
+        const val BATCH_SIZE = 256
+    }
+}
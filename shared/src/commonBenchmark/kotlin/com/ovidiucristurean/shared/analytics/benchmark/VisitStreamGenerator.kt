@@ -0,0 +1,96 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlinx.datetime.Instant
+import kotlinx.datetime.TimeZone
+import kotlinx.datetime.toLocalDateTime
+import kotlin.math.floor
+import kotlin.math.pow
+import kotlin.random.Random
+import kotlin.time.Duration.Companion.minutes
+
+/**
+ * Deterministic stream of skewed, seasonal visits. The same [seed] always yields the same stream.
+ *
+ * Shop popularity follows a Zipf law over [shopCount] shops, so `shop-0` gets the most visits.
+ * Visit volume follows [hourlyWeights] over the local day and [weekdayWeights] over the week, in
+ * [timeZone]. The first quarter hour after [openingHour] is multiplied by [openingBurst].
+ * Timestamps are strictly increasing.
+ */
+class VisitStreamGenerator(
+    private val seed: Long,
+    private val shopCount: Int = 50,
+    zipfExponent: Double = 1.1,
+    private val visitsPerDay: Double = 10_000.0,
+    private val timeZone: TimeZone = TimeZone.UTC,
+    private val hourlyWeights: DoubleArray = DEFAULT_HOURLY_WEIGHTS,
+    private val weekdayWeights: DoubleArray = DEFAULT_WEEKDAY_WEIGHTS,
+    private val openingHour: Int = 9,
+    private val openingBurst: Double = 3.0
+) {
+    private val shopCumulativeWeights: DoubleArray
+
+    init {
+        require(shopCount > 0) { "shopCount must be positive" }
+        require(hourlyWeights.size == 24) { "hourlyWeights needs one weight per hour" }
+        require(weekdayWeights.size == 7) { "weekdayWeights needs one weight per day, Monday first" }
+
+        var total = 0.0
+        shopCumulativeWeights = DoubleArray(shopCount) { rank ->
+            total += 1.0 / (rank + 1.0).pow(zipfExponent)
+            total
+        }
+    }
+
+    fun generate(start: Instant): Sequence<VisitEvent> = sequence {
+        val random = Random(seed)
+        val hourlyTotal = hourlyWeights.sum()
+        var slotStart = start
+        var lastMillis = Long.MIN_VALUE
+
+        while (true) {
+            val local = slotStart.toLocalDateTime(timeZone)
+            var expected = visitsPerDay * weekdayWeights[local.dayOfWeek.ordinal] *
+                hourlyWeights[local.hour] / hourlyTotal / SLOTS_PER_HOUR
+            if (local.hour == openingHour && local.minute < SLOT.inWholeMinutes) {
+                expected *= openingBurst
+            }
+
+            // Rounding up with probability equal to the fraction keeps the mean exact.
+            val count = floor(expected + random.nextDouble()).toInt()
+            val offsets = LongArray(count) { random.nextLong(SLOT.inWholeMilliseconds) }
+            offsets.sort()
+            offsets.forEach { offset ->
+                val millis = maxOf(slotStart.toEpochMilliseconds() + offset, lastMillis + 1)
+                lastMillis = millis
+                yield(VisitEvent(nextShopId(random), Instant.fromEpochMilliseconds(millis)))
+            }
+            slotStart += SLOT
+        }
+    }
+
+    private fun nextShopId(random: Random): String {
+        val target = random.nextDouble() * shopCumulativeWeights.last()
+        var low = 0
+        var high = shopCumulativeWeights.lastIndex
+        while (low < high) {
+            val mid = (low + high) ushr 1
+            if (shopCumulativeWeights[mid] < target) low = mid + 1 else high = mid
+        }
+        return "shop-$low"
+    }
+
+    companion object {
+        private val SLOT = 15.minutes
+        private const val SLOTS_PER_HOUR = 4
+
+        // Closed at night, a morning peak and a larger evening peak.
+        val DEFAULT_HOURLY_WEIGHTS = doubleArrayOf(
+            0.1, 0.05, 0.05, 0.05, 0.05, 0.1, 0.3, 0.6, 1.0, 1.6, 1.8, 1.9,
+            2.2, 2.0, 1.7, 1.6, 1.8, 2.3, 2.6, 2.4, 1.8, 1.1, 0.5, 0.2
+        )
+
+        // Monday first, busier towards the weekend.
+        val DEFAULT_WEEKDAY_WEIGHTS = doubleArrayOf(0.8, 0.85, 0.9, 0.95, 1.15, 1.4, 0.95)
+    }
+}
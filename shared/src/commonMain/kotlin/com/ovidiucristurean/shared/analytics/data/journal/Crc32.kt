@@ -0,0 +1,24 @@
+package com.ovidiucristurean.shared.analytics.data.journal
+
+/**
+ * CRC-32 (IEEE 802.3), the checksum zlib and java.util.zip use.
+ */
+internal object Crc32 {
+    private val table = IntArray(256) { index ->
+        var crc = index
+        repeat(8) {
+            crc = if (crc and 1 != 0) (crc ushr 1) xor POLYNOMIAL else crc ushr 1
+        }
+        crc
+    }
+
+    fun of(bytes: ByteArray, offset: Int = 0, length: Int = bytes.size - offset): Int {
+        var crc = -1
+        for (index in offset until offset + length) {
+            crc = table[(crc xor bytes[index].toInt()) and 0xff] xor (crc ushr 8)
+        }
+        return crc.inv()
+    }
+
+    private const val POLYNOMIAL = 0xEDB88320.toInt()
+}
@@ -0,0 +1,172 @@
+package com.ovidiucristurean.shared.analytics.data.journal
+
+import com.ovidiucristurean.shared.analytics.domain.sketch.HyperLogLog
+import okio.Buffer
+import okio.FileHandle
+import okio.FileSystem
+import okio.Path
+import okio.buffer
+import okio.use
+
+/**
+ * One visit as stored in the journal: the `shops_dict` key of the shop, the epoch millis and, if
+ * the visit had a visitor key, its [HyperLogLog.hashOf]. The key itself is never written.
+ */
+internal class JournalRecord(
+    val shopKey: Long,
+    val epochMillis: Long,
+    val visitorHash: Long? = null
+)
+
+/**
+ * A sealed journal segment. Its file is never written again.
+ */
+internal class JournalSegment(
+    val id: Long,
+    val path: Path
+)
+
+/**
+ * Append-only visit log in [directory], split into numbered segment files of fixed-size records.
+ *
+ * A record is 24 bytes: the shop key as an Int, the epoch millis and the visitor hash as Longs,
+ * and a CRC-32 of all three. The sign bit of the shop key, never set by a real key, marks a record
+ * that has a visitor hash.
+ * Appends are synced before they return. A torn or corrupt record, as left by a crash during an
+ * append, ends its segment, and everything after it in that file is ignored.
+ *
+ * Not thread-safe: callers serialize [open], [append] and [seal].
+ */
+internal class VisitJournal(
+    private val fileSystem: FileSystem,
+    private val directory: Path,
+    private val maxSegmentRecords: Int = DEFAULT_MAX_SEGMENT_RECORDS
+) {
+    private var activeId = 0L
+    private var activeHandle: FileHandle? = null
+    private var activeRecords = 0
+
+    /**
+     * Prepares for appending. New segments are numbered after [minSegmentId] and after every
+     * segment already on disk, so ids are never reused even once old files are deleted.
+     */
+    fun open(minSegmentId: Long) {
+        fileSystem.createDirectories(directory)
+        activeId = maxOf(minSegmentId, segmentIds().maxOrNull() ?: 0L)
+    }
+
+    fun append(records: List<JournalRecord>) {
+        if (records.isEmpty()) return
+        var start = 0
+        while (start < records.size) {
+            if (activeRecords == maxSegmentRecords) seal()
+            val handle = activeHandle ?: startSegment()
+            val end = minOf(records.size, start + maxSegmentRecords - activeRecords)
+
+            val buffer = Buffer()
+            val bytes = ByteArray(RECORD_PAYLOAD_SIZE)
+            for (index in start until end) {
+                encodePayload(records[index], bytes)
+                buffer.write(bytes).writeInt(Crc32.of(bytes))
+            }
+            try {
+                handle.write(handle.size(), buffer, buffer.size)
+                handle.flush()
+            } catch (e: Exception) {
+                // A partial write would misalign every later record in this file.
+                seal()
+                throw e
+            }
+
+            activeRecords += end - start
+            start = end
+        }
+    }
+
+    /**
+     * Closes the active segment, if it has records, so that it shows up in [sealedSegments].
+     */
+    fun seal() {
+        activeHandle?.close()
+        activeHandle = null
+        activeRecords = 0
+    }
+
+    /**
+     * Sealed segments in id order. The active segment is left out.
+     */
+    fun sealedSegments(): List<JournalSegment> {
+        val active = activeId.takeIf { activeHandle != null }
+        return segmentIds()
+            .filter { it != active }
+            .sorted()
+            .map { JournalSegment(it, segmentPath(it)) }
+    }
+
+    fun read(segment: JournalSegment): List<JournalRecord> = buildList {
+        fileSystem.source(segment.path).buffer().use { source ->
+            val bytes = ByteArray(RECORD_PAYLOAD_SIZE)
+            while (source.request(RECORD_SIZE.toLong())) {
+                source.readFully(bytes)
+                if (source.readInt() != Crc32.of(bytes)) break
+                add(decodePayload(bytes))
+            }
+        }
+    }
+
+    fun delete(segment: JournalSegment) {
+        fileSystem.delete(segment.path, mustExist = false)
+    }
+
+    private fun startSegment(): FileHandle {
+        activeId++
+        return fileSystem.openReadWrite(segmentPath(activeId), mustCreate = true)
+            .also { activeHandle = it }
+    }
+
+    private fun segmentIds(): List<Long> =
+        fileSystem.list(directory).mapNotNull { it.name.removeSuffix(SEGMENT_SUFFIX).toLongOrNull() }
+
+    private fun segmentPath(id: Long): Path =
+        directory / "${id.toString().padStart(SEGMENT_NAME_DIGITS, '0')}$SEGMENT_SUFFIX"
+
+    private fun encodePayload(record: JournalRecord, bytes: ByteArray) {
+        require(record.shopKey in 0..Int.MAX_VALUE) { "Shop key out of range: ${record.shopKey}" }
+        val visitorHash = record.visitorHash
+        val shopKey = record.shopKey.toInt() or (if (visitorHash != null) HAS_VISITOR else 0)
+        for (index in 0 until 4) {
+            bytes[index] = (shopKey ushr (24 - 8 * index)).toByte()
+        }
+        for (index in 0 until 8) {
+            bytes[4 + index] = (record.epochMillis ushr (56 - 8 * index)).toByte()
+            bytes[12 + index] = ((visitorHash ?: 0L) ushr (56 - 8 * index)).toByte()
+        }
+    }
+
+    private fun decodePayload(bytes: ByteArray): JournalRecord {
+        var shopKey = 0
+        for (index in 0 until 4) {
+            shopKey = (shopKey shl 8) or (bytes[index].toInt() and 0xff)
+        }
+        var epochMillis = 0L
+        var visitorHash = 0L
+        for (index in 0 until 8) {
+            epochMillis = (epochMillis shl 8) or (bytes[4 + index].toLong() and 0xff)
+            visitorHash = (visitorHash shl 8) or (bytes[12 + index].toLong() and 0xff)
+        }
+        return JournalRecord(
+            shopKey = (shopKey and HAS_VISITOR.inv()).toLong(),
+            epochMillis = epochMillis,
+            visitorHash = visitorHash.takeIf { shopKey and HAS_VISITOR != 0 }
+        )
+    }
+
+    companion object {
+        const val DEFAULT_MAX_SEGMENT_RECORDS = 64 * 1024
+        private const val RECORD_PAYLOAD_SIZE = 20
+        private const val HAS_VISITOR = Int.MIN_VALUE
+        private const val RECORD_SIZE = RECORD_PAYLOAD_SIZE + 4
+        private const val SEGMENT_SUFFIX = ".journal"
+        private const val SEGMENT_NAME_DIGITS = 20
+    }
+}
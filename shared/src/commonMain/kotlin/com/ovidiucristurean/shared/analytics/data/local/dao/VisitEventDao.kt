@@ -2,22 +2,440 @@ package com.ovidiucristurean.shared.analytics.data.local.dao
 
 import androidx.room.Dao
 import androidx.room.Insert
+import androidx.room.OnConflictStrategy
 import androidx.room.Query
+import androidx.room.Transaction
+import com.ovidiucristurean.shared.analytics.data.local.entity.JournalCheckpointEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.RetentionStateEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.RollupStateEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDailyServiceTimesEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.toSketch
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDailyVisitorsEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDailyVisitsEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDictEntity
 import com.ovidiucristurean.shared.analytics.data.local.entity.VisitEventEntity
+import com.ovidiucristurean.shared.analytics.data.local.model.DailyVisitCount
+import com.ovidiucristurean.shared.analytics.data.local.model.HourOfWeekVisitCount
+import com.ovidiucristurean.shared.analytics.domain.sketch.HyperLogLog
+import com.ovidiucristurean.shared.analytics.domain.time.utcOffsetSegments
+import kotlinx.datetime.DateTimeUnit
+import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
+import kotlinx.datetime.atStartOfDayIn
+import kotlinx.datetime.plus
+import kotlinx.datetime.toLocalDateTime
 
 @Dao
 interface VisitEventDao {
     @Insert
     suspend fun insert(event: VisitEventEntity)
 
+    // Runs in a single transaction and binds every row to the same prepared statement.
+    @Insert
+    suspend fun insertAll(events: List<VisitEventEntity>)
+
+    @Transaction
+    suspend fun insertAllWithDailyVisits(
+        events: List<VisitEventEntity>,
+        dailyVisits: List<ShopDailyVisitsEntity>
+    ) {
+        insertAll(events)
+        insertDailyVisitsIfAbsent(dailyVisits.map { it.copy(count = 0) })
+        dailyVisits.forEach { incrementDailyVisits(it.shopKey, it.day, it.count) }
+    }
+
+    @Transaction
+    suspend fun insertAllWithDailyStats(
+        events: List<VisitEventEntity>,
+        dailyVisits: List<ShopDailyVisitsEntity>,
+        dailyVisitors: List<ShopDailyVisitorsEntity>
+    ) {
+        insertAllWithDailyVisits(events, dailyVisits)
+        mergeDailyVisitors(dailyVisitors)
+    }
+
+    @Query("SELECT sketch FROM shop_daily_visitors WHERE shopKey = :shopKey AND day = :day")
+    suspend fun getDailyVisitorSketch(shopKey: Long, day: Long): ByteArray?
+
+    @Insert(onConflict = OnConflictStrategy.REPLACE)
+    suspend fun setDailyVisitors(dailyVisitors: ShopDailyVisitorsEntity)
+
+    // Merging is idempotent, so applying the same sketch twice does not count anyone twice.
+    @Transaction
+    suspend fun mergeDailyVisitors(dailyVisitors: List<ShopDailyVisitorsEntity>) {
+        dailyVisitors.forEach { update ->
+            val stored = getDailyVisitorSketch(update.shopKey, update.day)
+            val sketch = if (stored == null) {
+                update.sketch
+            } else {
+                HyperLogLog.fromByteArray(stored)
+                    .apply { merge(HyperLogLog.fromByteArray(update.sketch)) }
+                    .toByteArray()
+            }
+            setDailyVisitors(ShopDailyVisitorsEntity(update.shopKey, update.day, sketch))
+        }
+    }
+
+    @Query("""
+        SELECT sketch FROM shop_daily_visitors
+        WHERE shopKey = :shopKey
+        AND day BETWEEN :fromDay AND :toDay
+    """)
+    suspend fun getDailyVisitorSketches(
+        shopKey: Long,
+        fromDay: Long,
+        toDay: Long
+    ): List<ByteArray>
+
+    @Query("SELECT * FROM shop_daily_service_times WHERE shopKey = :shopKey AND day = :day")
+    suspend fun getDailyServiceTimes(shopKey: Long, day: Long): ShopDailyServiceTimesEntity?
+
+    @Insert(onConflict = OnConflictStrategy.REPLACE)
+    suspend fun setDailyServiceTimes(dailyServiceTimes: ShopDailyServiceTimesEntity)
+
+    // Unlike visitor sketches, digests add up, so each update must be applied exactly once.
+    @Transaction
+    suspend fun mergeDailyServiceTimes(dailyServiceTimes: List<ShopDailyServiceTimesEntity>) {
+        dailyServiceTimes.forEach { update ->
+            val stored = getDailyServiceTimes(update.shopKey, update.day)
+            val merged = if (stored == null) {
+                update
+            } else {
+                val sketch = stored.toSketch().apply { merge(update.toSketch()) }
+                ShopDailyServiceTimesEntity(
+                    shopKey = update.shopKey,
+                    day = update.day,
+                    createdToCompleted = sketch.createdToCompleted.toByteArray(),
+                    readToCompleted = sketch.readToCompleted.toByteArray()
+                )
+            }
+            setDailyServiceTimes(merged)
+        }
+    }
+
+    @Query("""
+        SELECT * FROM shop_daily_service_times
+        WHERE shopKey = :shopKey
+        AND day BETWEEN :fromDay AND :toDay
+    """)
+    suspend fun getDailyServiceTimesInRange(
+        shopKey: Long,
+        fromDay: Long,
+        toDay: Long
+    ): List<ShopDailyServiceTimesEntity>
+
+    @Transaction
+    suspend fun insertJournalSegment(
+        events: List<VisitEventEntity>,
+        dailyVisits: List<ShopDailyVisitsEntity>,
+        dailyVisitors: List<ShopDailyVisitorsEntity>,
+        checkpoint: JournalCheckpointEntity
+    ) {
+        insertAllWithDailyStats(events, dailyVisits, dailyVisitors)
+        setJournalCheckpoint(checkpoint)
+    }
+
+    @Insert(onConflict = OnConflictStrategy.REPLACE)
+    suspend fun setJournalCheckpoint(checkpoint: JournalCheckpointEntity)
+
+    @Query("SELECT lastAppliedSegment FROM journal_checkpoint WHERE id = 0")
+    suspend fun getLastAppliedJournalSegment(): Long?
+
+    @Insert(onConflict = OnConflictStrategy.REPLACE)
+    suspend fun setRetentionState(state: RetentionStateEntity)
+
+    @Query("SELECT rawHorizonMillis FROM retention_state WHERE id = 0")
+    suspend fun getRawHorizon(): Long?
+
+    @Query("SELECT * FROM visit_events WHERE timestampEpochMillis < :before LIMIT :limit")
+    suspend fun getVisitsBefore(before: Long, limit: Int): List<VisitEventEntity>
+
+    @Query("DELETE FROM visit_events WHERE id IN (:ids)")
+    suspend fun deleteVisits(ids: List<Long>): Int
+
+    // Deletes up to [limit] raw visits before [before], a rollup day start in [timeZone], and
+    // returns how many were deleted. One short write transaction per call, so a purge never holds
+    // the write lock for long. Deletes nothing and throws IllegalStateException if the rollup
+    // holds fewer visits than the raw rows left on any shop and day that the chunk touches.
+    @Transaction
+    suspend fun deleteRolledUpVisitsBefore(timeZone: TimeZone, before: Long, limit: Int): Int {
+        val chunk = getVisitsBefore(before, limit)
+        if (chunk.isEmpty()) return 0
+        val shopKeys = chunk.mapTo(HashSet()) { it.shopKey }.toList()
+        // Whole rollup days, from the first the chunk touches to the last.
+        val from = chunk.minOf { it.timestampEpochMillis }.toLocalDate(timeZone)
+            .atStartOfDayIn(timeZone).toEpochMilliseconds()
+        val to = chunk.maxOf { it.timestampEpochMillis }.toLocalDate(timeZone)
+            .plus(1, DateTimeUnit.DAY).atStartOfDayIn(timeZone).toEpochMilliseconds() - 1
+
+        val rawCounts = mutableMapOf<Pair<Long, Long>, Int>()
+        timeZone.utcOffsetSegments(from, to).forEach { segment ->
+            countVisitsPerDayForShops(
+                shopKeys = shopKeys,
+                from = segment.fromEpochMillis,
+                to = segment.toEpochMillis,
+                offsetMillis = segment.offsetMillis
+            ).forEach { rawCounts[it.shopKey to it.day] = it.count }
+        }
+        val rolledUp = getDailyVisitsForShops(
+            shopKeys = shopKeys,
+            fromDay = rawCounts.keys.minOf { it.second },
+            toDay = rawCounts.keys.maxOf { it.second }
+        ).associate { (it.shopKey to it.day) to it.count }
+        rawCounts.forEach { (key, count) ->
+            check((rolledUp[key] ?: 0) >= count) {
+                "Rollup of shop ${key.first} on day ${key.second} is missing raw visits"
+            }
+        }
+        return deleteVisits(chunk.map { it.id })
+    }
+
     @Query("""
         SELECT * FROM visit_events
-        WHERE shopId = :shopId
+        WHERE shopKey = :shopKey
         AND timestampEpochMillis BETWEEN :from AND :to
     """)
     suspend fun getVisits(
-        shopId: String,
+        shopKey: Long,
+        from: Long,
+        to: Long
+    ): List<VisitEventEntity>
+
+    // Keyset page: the rows after (afterMillis, afterId) in (timestamp, id) order. The index on
+    // (shopKey, timestampEpochMillis) also holds the rowid, so this is a plain index range scan.
+    @Query("""
+        SELECT * FROM visit_events
+        WHERE shopKey = :shopKey
+        AND (timestampEpochMillis > :afterMillis
+            OR (timestampEpochMillis = :afterMillis AND id > :afterId))
+        AND timestampEpochMillis <= :to
+        ORDER BY timestampEpochMillis, id
+        LIMIT :limit
+    """)
+    suspend fun getVisitsPage(
+        shopKey: Long,
+        afterMillis: Long,
+        afterId: Long,
+        to: Long,
+        limit: Int
+    ): List<VisitEventEntity>
+
+    // Row ids come from AUTOINCREMENT, so they only grow and work as a write watermark.
+    @Query("SELECT COALESCE(MAX(id), 0) FROM visit_events")
+    suspend fun getMaxVisitId(): Long
+
+    @Query("""
+        SELECT * FROM visit_events
+        WHERE shopKey = :shopKey
+        AND id > :afterId AND id <= :upToId
+        AND timestampEpochMillis BETWEEN :from AND :to
+    """)
+    suspend fun getVisitsRecordedBetween(
+        shopKey: Long,
+        afterId: Long,
+        upToId: Long,
         from: Long,
         to: Long
     ): List<VisitEventEntity>
+
+    @Query("""
+        SELECT COUNT(*) FROM visit_events
+        WHERE shopKey = :shopKey
+        AND timestampEpochMillis BETWEEN :from AND :to
+    """)
+    suspend fun countVisits(
+        shopKey: Long,
+        from: Long,
+        to: Long
+    ): Int
+
+    // Buckets by local day for a stretch of time in which the UTC offset is constant. SQLite
+    // division truncates toward zero, so the remainder is made non-negative first; days before
+    // 1970 then floor like UtcOffsetSegment.epochDayOf.
+    @Query("""
+        SELECT (timestampEpochMillis + :offsetMillis
+            - ((timestampEpochMillis + :offsetMillis) % 86400000 + 86400000) % 86400000)
+            / 86400000 AS epochDay,
+        COUNT(*) AS visitCount
+        FROM visit_events
+        WHERE shopKey = :shopKey
+        AND timestampEpochMillis BETWEEN :from AND :to
+        GROUP BY epochDay
+    """)
+    suspend fun countVisitsPerDay(
+        shopKey: Long,
+        from: Long,
+        to: Long,
+        offsetMillis: Long
+    ): List<DailyVisitCount>
+
+    // Buckets by local hour of the week, Monday 00:00 first, for a stretch with a constant offset.
+    // Epoch day 0 was a Thursday, so local millis are shifted by three days and taken modulo a
+    // week. The remainder is made non-negative, since SQLite's % keeps the sign of the dividend,
+    // so hours before 1970 match UtcOffsetSegment.hourOfWeekOf.
+    @Query("""
+        SELECT ((timestampEpochMillis + :offsetMillis + 259200000) % 604800000 + 604800000)
+            % 604800000 / 3600000 AS hourOfWeek,
+        COUNT(*) AS visitCount
+        FROM visit_events
+        WHERE shopKey = :shopKey
+        AND timestampEpochMillis BETWEEN :from AND :to
+        GROUP BY hourOfWeek
+    """)
+    suspend fun countVisitsPerHourOfWeek(
+        shopKey: Long,
+        from: Long,
+        to: Long,
+        offsetMillis: Long
+    ): List<HourOfWeekVisitCount>
+
+    @Query("SELECT * FROM shops_dict")
+    suspend fun getShops(): List<ShopDictEntity>
+
+    @Query("SELECT id FROM shops_dict WHERE externalId = :externalId")
+    suspend fun getShopKey(externalId: String): Long?
+
+    // Returns -1 when the shop is already in the dictionary.
+    @Insert(onConflict = OnConflictStrategy.IGNORE)
+    suspend fun insertShop(shop: ShopDictEntity): Long
+
+    @Transaction
+    suspend fun getOrCreateShopKeys(externalIds: Collection<String>): Map<String, Long> {
+        return externalIds.associateWith { externalId ->
+            getShopKey(externalId) ?: insertShop(ShopDictEntity(externalId = externalId))
+        }
+    }
+
+    // countVisitsPerDay for several shops in one grouped scan, with the same floored days.
+    @Query("""
+        SELECT shopKey, (timestampEpochMillis + :offsetMillis
+            - ((timestampEpochMillis + :offsetMillis) % 86400000 + 86400000) % 86400000)
+            / 86400000 AS day,
+        COUNT(*) AS count
+        FROM visit_events
+        WHERE shopKey IN (:shopKeys)
+        AND timestampEpochMillis BETWEEN :from AND :to
+        GROUP BY shopKey, day
+    """)
+    suspend fun countVisitsPerDayForShops(
+        shopKeys: List<Long>,
+        from: Long,
+        to: Long,
+        offsetMillis: Long
+    ): List<ShopDailyVisitsEntity>
+
+    @Insert(onConflict = OnConflictStrategy.IGNORE)
+    suspend fun insertDailyVisitsIfAbsent(dailyVisits: List<ShopDailyVisitsEntity>)
+
+    @Query("""
+        UPDATE shop_daily_visits SET count = count + :delta
+        WHERE shopKey = :shopKey AND day = :day
+    """)
+    suspend fun incrementDailyVisits(
+        shopKey: Long,
+        day: Long,
+        delta: Int
+    )
+
+    @Query("""
+        SELECT day AS epochDay, count AS visitCount FROM shop_daily_visits
+        WHERE shopKey = :shopKey
+        AND day BETWEEN :fromDay AND :toDay
+    """)
+    suspend fun getDailyVisits(
+        shopKey: Long,
+        fromDay: Long,
+        toDay: Long
+    ): List<DailyVisitCount>
+
+    @Query("""
+        SELECT * FROM shop_daily_visits
+        WHERE shopKey IN (:shopKeys)
+        AND day BETWEEN :fromDay AND :toDay
+    """)
+    suspend fun getDailyVisitsForShops(
+        shopKeys: List<Long>,
+        fromDay: Long,
+        toDay: Long
+    ): List<ShopDailyVisitsEntity>
+
+    @Query("""
+        SELECT COALESCE(SUM(count), 0) FROM shop_daily_visits
+        WHERE shopKey = :shopKey
+        AND day BETWEEN :fromDay AND :toDay
+    """)
+    suspend fun sumDailyVisits(
+        shopKey: Long,
+        fromDay: Long,
+        toDay: Long
+    ): Int
+
+    @Insert(onConflict = OnConflictStrategy.REPLACE)
+    suspend fun setRollupState(state: RollupStateEntity)
+
+    @Query("SELECT timeZoneId FROM rollup_state WHERE id = 0")
+    suspend fun getRollupTimeZoneId(): String?
+
+    @Query("SELECT MIN(timestampEpochMillis) FROM visit_events")
+    suspend fun getOldestTimestamp(): Long?
+
+    @Query("SELECT MAX(timestampEpochMillis) FROM visit_events")
+    suspend fun getNewestTimestamp(): Long?
+
+    @Query("""
+        SELECT shopKey, (timestampEpochMillis + :offsetMillis
+            - ((timestampEpochMillis + :offsetMillis) % 86400000 + 86400000) % 86400000)
+            / 86400000 AS day,
+        COUNT(*) AS count
+        FROM visit_events
+        WHERE timestampEpochMillis BETWEEN :from AND :to
+        GROUP BY shopKey, day
+    """)
+    suspend fun aggregateDailyVisits(
+        from: Long,
+        to: Long,
+        offsetMillis: Long
+    ): List<ShopDailyVisitsEntity>
+
+    @Query("DELETE FROM shop_daily_visits WHERE day >= :fromDay")
+    suspend fun deleteDailyVisitsFrom(fromDay: Long)
+
+    // Recomputes shop_daily_visits from the raw rows at or after [fromMillis], bucketed by local
+    // day in [timeZone]. Rows before [keepBeforeDay] are kept, since their raw rows may have been
+    // purged, and a recomputed day that shares a row with them is added to it. Records [timeZone]
+    // in `rollup_state`, and [retentionState] if given, in the same transaction.
+    @Transaction
+    suspend fun rebuildDailyVisits(
+        timeZone: TimeZone,
+        keepBeforeDay: Long,
+        fromMillis: Long,
+        retentionState: RetentionStateEntity? = null
+    ) {
+        deleteDailyVisitsFrom(keepBeforeDay)
+        setRollupState(RollupStateEntity(timeZoneId = timeZone.id))
+        retentionState?.let { setRetentionState(it) }
+        val oldest = maxOf(getOldestTimestamp() ?: return, fromMillis)
+        val newest = getNewestTimestamp() ?: return
+
+        val counts = mutableMapOf<Pair<Long, Long>, Int>()
+        timeZone.utcOffsetSegments(oldest, newest).forEach { segment ->
+            aggregateDailyVisits(
+                from = segment.fromEpochMillis,
+                to = segment.toEpochMillis,
+                offsetMillis = segment.offsetMillis
+            ).forEach {
+                val key = it.shopKey to it.day
+                counts[key] = (counts[key] ?: 0) + it.count
+            }
+        }
+        val dailyVisits = counts.map { (key, count) ->
+            ShopDailyVisitsEntity(key.first, key.second, count)
+        }
+        insertDailyVisitsIfAbsent(dailyVisits.map { it.copy(count = 0) })
+        dailyVisits.forEach { incrementDailyVisits(it.shopKey, it.day, it.count) }
+    }
 }
+
+private fun Long.toLocalDate(timeZone: TimeZone): LocalDate =
+    Instant.fromEpochMilliseconds(this).toLocalDateTime(timeZone).date
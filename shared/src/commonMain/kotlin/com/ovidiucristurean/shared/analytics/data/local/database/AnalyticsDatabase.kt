@@ -5,9 +5,28 @@ import androidx.room.Database
 import androidx.room.RoomDatabase
 import androidx.room.RoomDatabaseConstructor
 import com.ovidiucristurean.shared.analytics.data.local.dao.VisitEventDao
+import com.ovidiucristurean.shared.analytics.data.local.entity.JournalCheckpointEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.RetentionStateEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.RollupStateEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDailyServiceTimesEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDailyVisitorsEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDailyVisitsEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDictEntity
 import com.ovidiucristurean.shared.analytics.data.local.entity.VisitEventEntity
 
-@Database(entities = [VisitEventEntity::class], version = 1)
+@Database(
+  entities = [
+    VisitEventEntity::class,
+    ShopDailyVisitsEntity::class,
+    ShopDictEntity::class,
+    JournalCheckpointEntity::class,
+    RetentionStateEntity::class,
+    ShopDailyVisitorsEntity::class,
+    ShopDailyServiceTimesEntity::class,
+    RollupStateEntity::class,
+  ],
+  version = 10
+)
 @ConstructedBy(AnalyticsDatabaseConstructor::class)
 abstract class AnalyticsDatabase : RoomDatabase() {
   abstract fun visitEventDao(): VisitEventDao
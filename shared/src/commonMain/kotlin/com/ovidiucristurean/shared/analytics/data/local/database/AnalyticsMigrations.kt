@@ -0,0 +1,183 @@
+package com.ovidiucristurean.shared.analytics.data.local.database
+
+import androidx.room.migration.Migration
+import androidx.sqlite.SQLiteConnection
+import androidx.sqlite.execSQL
+
+// Range queries filter on shopId and timestamp, so index both instead of scanning the table.
+val MIGRATION_1_2 = object : Migration(1, 2) {
+  override fun migrate(connection: SQLiteConnection) {
+    connection.execSQL(
+      "CREATE INDEX IF NOT EXISTS `index_visit_events_shopId_timestampEpochMillis` " +
+        "ON `visit_events` (`shopId`, `timestampEpochMillis`)"
+    )
+  }
+}
+
+// Replaces the random UUID text key with an INTEGER rowid. Rows are copied in timestamp order so
+// the new ids follow insertion time.
+val MIGRATION_2_3 = object : Migration(2, 3) {
+  override fun migrate(connection: SQLiteConnection) {
+    connection.execSQL(
+      "CREATE TABLE IF NOT EXISTS `visit_events_new` (" +
+        "`id` INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, " +
+        "`shopId` TEXT NOT NULL, " +
+        "`timestampEpochMillis` INTEGER NOT NULL)"
+    )
+    connection.execSQL(
+      "INSERT INTO `visit_events_new` (`shopId`, `timestampEpochMillis`) " +
+        "SELECT `shopId`, `timestampEpochMillis` FROM `visit_events` " +
+        "ORDER BY `timestampEpochMillis`"
+    )
+    connection.execSQL("DROP TABLE `visit_events`")
+    connection.execSQL("ALTER TABLE `visit_events_new` RENAME TO `visit_events`")
+    connection.execSQL(
+      "CREATE INDEX IF NOT EXISTS `index_visit_events_shopId_timestampEpochMillis` " +
+        "ON `visit_events` (`shopId`, `timestampEpochMillis`)"
+    )
+  }
+}
+
+// Adds the per-day rollup. It starts empty because the day buckets depend on the time zone of
+// RoomAnalyticsRepository, which fills it from the raw rows once `rollup_state` says it has to.
+val MIGRATION_3_4 = object : Migration(3, 4) {
+  override fun migrate(connection: SQLiteConnection) {
+    connection.execSQL(
+      "CREATE TABLE IF NOT EXISTS `shop_daily_visits` (" +
+        "`shopId` TEXT NOT NULL, " +
+        "`day` INTEGER NOT NULL, " +
+        "`count` INTEGER NOT NULL, " +
+        "PRIMARY KEY(`shopId`, `day`))"
+    )
+  }
+}
+
+// Moves the shop id strings into `shops_dict` and makes both visit tables reference it by integer
+// key. Existing ids are kept so the rowid order is unchanged.
+val MIGRATION_4_5 = object : Migration(4, 5) {
+  override fun migrate(connection: SQLiteConnection) {
+    connection.execSQL(
+      "CREATE TABLE IF NOT EXISTS `shops_dict` (" +
+        "`id` INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, " +
+        "`externalId` TEXT NOT NULL)"
+    )
+    connection.execSQL(
+      "CREATE UNIQUE INDEX IF NOT EXISTS `index_shops_dict_externalId` " +
+        "ON `shops_dict` (`externalId`)"
+    )
+    connection.execSQL(
+      "INSERT OR IGNORE INTO `shops_dict` (`externalId`) " +
+        "SELECT DISTINCT `shopId` FROM `visit_events` " +
+        "UNION SELECT DISTINCT `shopId` FROM `shop_daily_visits`"
+    )
+
+    connection.execSQL(
+      "CREATE TABLE IF NOT EXISTS `visit_events_new` (" +
+        "`id` INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, " +
+        "`shopKey` INTEGER NOT NULL, " +
+        "`timestampEpochMillis` INTEGER NOT NULL)"
+    )
+    connection.execSQL(
+      "INSERT INTO `visit_events_new` (`id`, `shopKey`, `timestampEpochMillis`) " +
+        "SELECT v.`id`, d.`id`, v.`timestampEpochMillis` FROM `visit_events` v " +
+        "JOIN `shops_dict` d ON d.`externalId` = v.`shopId`"
+    )
+    connection.execSQL("DROP TABLE `visit_events`")
+    connection.execSQL("ALTER TABLE `visit_events_new` RENAME TO `visit_events`")
+    connection.execSQL(
+      "CREATE INDEX IF NOT EXISTS `index_visit_events_shopKey_timestampEpochMillis` " +
+        "ON `visit_events` (`shopKey`, `timestampEpochMillis`)"
+    )
+
+    connection.execSQL(
+      "CREATE TABLE IF NOT EXISTS `shop_daily_visits_new` (" +
+        "`shopKey` INTEGER NOT NULL, " +
+        "`day` INTEGER NOT NULL, " +
+        "`count` INTEGER NOT NULL, " +
+        "PRIMARY KEY(`shopKey`, `day`))"
+    )
+    connection.execSQL(
+      "INSERT INTO `shop_daily_visits_new` (`shopKey`, `day`, `count`) " +
+        "SELECT d.`id`, r.`day`, r.`count` FROM `shop_daily_visits` r " +
+        "JOIN `shops_dict` d ON d.`externalId` = r.`shopId`"
+    )
+    connection.execSQL("DROP TABLE `shop_daily_visits`")
+    connection.execSQL("ALTER TABLE `shop_daily_visits_new` RENAME TO `shop_daily_visits`")
+  }
+}
+
+// Adds the checkpoint that makes visit journal replay idempotent.
+val MIGRATION_5_6 = object : Migration(5, 6) {
+  override fun migrate(connection: SQLiteConnection) {
+    connection.execSQL(
+      "CREATE TABLE IF NOT EXISTS `journal_checkpoint` (" +
+        "`id` INTEGER NOT NULL, " +
+        "`lastAppliedSegment` INTEGER NOT NULL, " +
+        "PRIMARY KEY(`id`))"
+    )
+  }
+}
+
+// Adds the raw visit horizon kept by the retention engine.
+val MIGRATION_6_7 = object : Migration(6, 7) {
+  override fun migrate(connection: SQLiteConnection) {
+    connection.execSQL(
+      "CREATE TABLE IF NOT EXISTS `retention_state` (" +
+        "`id` INTEGER NOT NULL, " +
+        "`rawHorizonMillis` INTEGER NOT NULL, " +
+        "PRIMARY KEY(`id`))"
+    )
+  }
+}
+
+// Adds the per-day visitor sketches behind unique visitor counts.
+val MIGRATION_7_8 = object : Migration(7, 8) {
+  override fun migrate(connection: SQLiteConnection) {
+    connection.execSQL(
+      "CREATE TABLE IF NOT EXISTS `shop_daily_visitors` (" +
+        "`shopKey` INTEGER NOT NULL, " +
+        "`day` INTEGER NOT NULL, " +
+        "`sketch` BLOB NOT NULL, " +
+        "PRIMARY KEY(`shopKey`, `day`))"
+    )
+  }
+}
+
+// Adds the per-day service time digests behind the service time quantiles.
+val MIGRATION_8_9 = object : Migration(8, 9) {
+  override fun migrate(connection: SQLiteConnection) {
+    connection.execSQL(
+      "CREATE TABLE IF NOT EXISTS `shop_daily_service_times` (" +
+        "`shopKey` INTEGER NOT NULL, " +
+        "`day` INTEGER NOT NULL, " +
+        "`createdToCompleted` BLOB NOT NULL, " +
+        "`readToCompleted` BLOB NOT NULL, " +
+        "PRIMARY KEY(`shopKey`, `day`))"
+    )
+  }
+}
+
+// Records the time zone the rollup was built in. The table starts empty, so the first open
+// rebuilds the rollup once, which also fills it for databases that skipped the lazy backfill.
+val MIGRATION_9_10 = object : Migration(9, 10) {
+  override fun migrate(connection: SQLiteConnection) {
+    connection.execSQL(
+      "CREATE TABLE IF NOT EXISTS `rollup_state` (" +
+        "`id` INTEGER NOT NULL, " +
+        "`timeZoneId` TEXT NOT NULL, " +
+        "PRIMARY KEY(`id`))"
+    )
+  }
+}
+
+val ANALYTICS_MIGRATIONS = arrayOf(
+  MIGRATION_1_2,
+  MIGRATION_2_3,
+  MIGRATION_3_4,
+  MIGRATION_4_5,
+  MIGRATION_5_6,
+  MIGRATION_6_7,
+  MIGRATION_7_8,
+  MIGRATION_8_9,
+  MIGRATION_9_10,
+)
@@ -0,0 +1,87 @@
+package com.ovidiucristurean.shared.analytics.data.local.database
+
+import androidx.room.RoomDatabase
+import androidx.sqlite.SQLiteConnection
+import androidx.sqlite.SQLiteDriver
+import androidx.sqlite.driver.bundled.BundledSQLiteDriver
+import androidx.sqlite.execSQL
+
+/**
+ * SQLite tuning for [AnalyticsDatabase], picked by name with [named].
+ *
+ * Every profile runs in WAL mode, where Room keeps one writer and several reader connections, so
+ * dashboard queries read a snapshot instead of waiting for the tracker's write transaction. The
+ * profiles differ in how much memory each connection may use and in how often the WAL is
+ * checkpointed back into the database file.
+ */
+enum class AnalyticsStorageProfile(
+  val profileName: String,
+  // Page cache per connection. Negative values are KiB, as in PRAGMA cache_size.
+  internal val cacheSize: Int,
+  internal val mmapSizeBytes: Long,
+  internal val walAutoCheckpointPages: Int,
+  internal val journalSizeLimitBytes: Long
+) {
+  // Fewer, larger checkpoints, so bursts of inserts mostly append to the WAL.
+  WRITE_HEAVY(
+    profileName = "write-heavy",
+    cacheSize = -8 * 1024,
+    mmapSizeBytes = 64L * 1024 * 1024,
+    walAutoCheckpointPages = 4000,
+    journalSizeLimitBytes = 64L * 1024 * 1024
+  ),
+
+  // A short WAL and a large, memory-mapped cache keep index range scans off the disk.
+  READ_HEAVY(
+    profileName = "read-heavy",
+    cacheSize = -32 * 1024,
+    mmapSizeBytes = 256L * 1024 * 1024,
+    walAutoCheckpointPages = 1000,
+    journalSizeLimitBytes = 16L * 1024 * 1024
+  ),
+
+  // Small caches on every connection and no memory mapping, for low-end devices.
+  LOW_MEMORY(
+    profileName = "low-memory",
+    cacheSize = -1024,
+    mmapSizeBytes = 0,
+    walAutoCheckpointPages = 500,
+    journalSizeLimitBytes = 4L * 1024 * 1024
+  );
+
+  companion object {
+    fun named(profileName: String): AnalyticsStorageProfile =
+      entries.firstOrNull { it.profileName == profileName }
+        ?: throw IllegalArgumentException("Unknown storage profile: $profileName")
+  }
+}
+
+/**
+ * Opens the database through [driver] in WAL mode and tunes every connection with [profile].
+ */
+fun RoomDatabase.Builder<AnalyticsDatabase>.setStorageProfile(
+  profile: AnalyticsStorageProfile,
+  driver: SQLiteDriver = BundledSQLiteDriver()
+): RoomDatabase.Builder<AnalyticsDatabase> =
+  setDriver(StorageProfileDriver(driver, profile))
+    .setJournalMode(RoomDatabase.JournalMode.WRITE_AHEAD_LOGGING)
+
+// Room's Callback.onOpen only sees the first connection, but these pragmas are per connection.
+private class StorageProfileDriver(
+  private val delegate: SQLiteDriver,
+  private val profile: AnalyticsStorageProfile
+) : SQLiteDriver {
+  override fun open(fileName: String): SQLiteConnection {
+    val connection = delegate.open(fileName)
+    // Only takes effect on a new, empty file, before Room creates the tables. VisitRetentionEngine
+    // then hands freed pages back in small steps instead of rewriting the whole file.
+    connection.execSQL("PRAGMA auto_vacuum = INCREMENTAL")
+    // WAL only needs to sync at checkpoints; a crash can lose the last commits, never corrupt.
+    connection.execSQL("PRAGMA synchronous = NORMAL")
+    connection.execSQL("PRAGMA cache_size = ${profile.cacheSize}")
+    connection.execSQL("PRAGMA mmap_size = ${profile.mmapSizeBytes}")
+    connection.execSQL("PRAGMA wal_autocheckpoint = ${profile.walAutoCheckpointPages}")
+    connection.execSQL("PRAGMA journal_size_limit = ${profile.journalSizeLimitBytes}")
+    return connection
+  }
+}
@@ -0,0 +1,14 @@
+package com.ovidiucristurean.shared.analytics.data.local.entity
+
+import androidx.room.Entity
+import androidx.room.PrimaryKey
+
+/**
+ * The last visit journal segment whose records are in `visit_events`. Written in the same
+ * transaction as the records, so a segment is never applied twice. There is only ever one row.
+ */
+@Entity(tableName = "journal_checkpoint")
+data class JournalCheckpointEntity(
+    @PrimaryKey val id: Int = 0,
+    val lastAppliedSegment: Long
+)
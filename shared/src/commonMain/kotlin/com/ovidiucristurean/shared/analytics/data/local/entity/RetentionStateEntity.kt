@@ -0,0 +1,14 @@
+package com.ovidiucristurean.shared.analytics.data.local.entity
+
+import androidx.room.Entity
+import androidx.room.PrimaryKey
+
+/**
+ * Raw visits before [rawHorizonMillis] have been deleted and only survive in `shop_daily_visits`.
+ * The horizon is the start of a rollup day and never moves back. There is only ever one row.
+ */
+@Entity(tableName = "retention_state")
+data class RetentionStateEntity(
+    @PrimaryKey val id: Int = 0,
+    val rawHorizonMillis: Long
+)
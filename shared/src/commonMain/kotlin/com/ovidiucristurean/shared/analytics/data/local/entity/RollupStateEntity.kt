@@ -0,0 +1,14 @@
+package com.ovidiucristurean.shared.analytics.data.local.entity
+
+import androidx.room.Entity
+import androidx.room.PrimaryKey
+
+/**
+ * The time zone `shop_daily_visits` was last rebuilt in. No row means the rollup was never built
+ * from the raw rows, as in a database migrated from before it existed. There is only ever one row.
+ */
+@Entity(tableName = "rollup_state")
+data class RollupStateEntity(
+    @PrimaryKey val id: Int = 0,
+    val timeZoneId: String
+)
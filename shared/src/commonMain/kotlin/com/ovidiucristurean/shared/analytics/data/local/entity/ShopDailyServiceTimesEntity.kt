@@ -0,0 +1,25 @@
+package com.ovidiucristurean.shared.analytics.data.local.entity
+
+import androidx.room.Entity
+import com.ovidiucristurean.shared.analytics.domain.sketch.ServiceTimeSketch
+import com.ovidiucristurean.shared.analytics.domain.sketch.TDigest
+
+/**
+ * Serialized t-digests of the service times of the item tags completed at one shop on one local
+ * day, keyed like `shop_daily_visits`.
+ */
+@Entity(
+    tableName = "shop_daily_service_times",
+    primaryKeys = ["shopKey", "day"]
+)
+class ShopDailyServiceTimesEntity(
+    val shopKey: Long,
+    val day: Long,
+    val createdToCompleted: ByteArray,
+    val readToCompleted: ByteArray
+)
+
+internal fun ShopDailyServiceTimesEntity.toSketch() = ServiceTimeSketch(
+    createdToCompleted = TDigest.fromByteArray(createdToCompleted),
+    readToCompleted = TDigest.fromByteArray(readToCompleted)
+)
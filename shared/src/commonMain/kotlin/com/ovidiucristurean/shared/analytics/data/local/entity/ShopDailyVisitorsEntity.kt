@@ -0,0 +1,17 @@
+package com.ovidiucristurean.shared.analytics.data.local.entity
+
+import androidx.room.Entity
+
+/**
+ * HyperLogLog sketch of the visitor keys seen at one shop on one local day, keyed like
+ * `shop_daily_visits`. Kept in its own table so that count queries never load the blobs.
+ */
+@Entity(
+    tableName = "shop_daily_visitors",
+    primaryKeys = ["shopKey", "day"]
+)
+class ShopDailyVisitorsEntity(
+    val shopKey: Long,
+    val day: Long,
+    val sketch: ByteArray
+)
@@ -0,0 +1,17 @@
+package com.ovidiucristurean.shared.analytics.data.local.entity
+
+import androidx.room.Entity
+
+/**
+ * Visit count of one shop on one local day, kept in step with `visit_events`. [day] is the
+ * epoch day in the time zone the rollup was built for, and [shopKey] is the `shops_dict.id`.
+ */
+@Entity(
+    tableName = "shop_daily_visits",
+    primaryKeys = ["shopKey", "day"]
+)
+data class ShopDailyVisitsEntity(
+    val shopKey: Long,
+    val day: Long,
+    val count: Int
+)
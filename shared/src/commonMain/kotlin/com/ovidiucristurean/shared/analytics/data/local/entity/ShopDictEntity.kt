@@ -0,0 +1,17 @@
+package com.ovidiucristurean.shared.analytics.data.local.entity
+
+import androidx.room.Entity
+import androidx.room.Index
+import androidx.room.PrimaryKey
+
+/**
+ * Maps an opaque server shop id to the small integer key that the visit tables store instead.
+ */
+@Entity(
+    tableName = "shops_dict",
+    indices = [Index(value = ["externalId"], unique = true)]
+)
+data class ShopDictEntity(
+    @PrimaryKey(autoGenerate = true) val id: Long = 0,
+    val externalId: String
+)
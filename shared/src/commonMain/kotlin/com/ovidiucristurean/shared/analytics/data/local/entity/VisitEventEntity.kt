@@ -1,11 +1,16 @@
 package com.ovidiucristurean.shared.analytics.data.local.entity
 
 import androidx.room.Entity
+import androidx.room.Index
 import androidx.room.PrimaryKey
 
-@Entity(tableName = "visit_events")
+@Entity(
+    tableName = "visit_events",
+    indices = [Index(value = ["shopKey", "timestampEpochMillis"])]
+)
 data class VisitEventEntity(
-    @PrimaryKey val id: String,
-    val shopId: String,
+    @PrimaryKey(autoGenerate = true) val id: Long = 0,
+    /** `shops_dict.id` of the visited shop. */
+    val shopKey: Long,
     val timestampEpochMillis: Long
 )
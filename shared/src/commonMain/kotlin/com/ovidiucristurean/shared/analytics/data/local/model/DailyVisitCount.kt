@@ -0,0 +1,6 @@
+package com.ovidiucristurean.shared.analytics.data.local.model
+
+data class DailyVisitCount(
+    val epochDay: Long,
+    val visitCount: Int
+)
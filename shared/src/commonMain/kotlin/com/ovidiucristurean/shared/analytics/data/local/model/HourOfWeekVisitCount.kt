@@ -0,0 +1,6 @@
+package com.ovidiucristurean.shared.analytics.data.local.model
+
+data class HourOfWeekVisitCount(
+    val hourOfWeek: Int,
+    val visitCount: Int
+)
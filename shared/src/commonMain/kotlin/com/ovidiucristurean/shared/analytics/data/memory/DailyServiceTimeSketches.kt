@@ -0,0 +1,29 @@
+package com.ovidiucristurean.shared.analytics.data.memory
+
+import com.ovidiucristurean.shared.analytics.domain.model.ItemTagLifecycle
+import com.ovidiucristurean.shared.analytics.domain.model.ServiceTimeStatistics
+import com.ovidiucristurean.shared.analytics.domain.sketch.ServiceTimeSketch
+import com.ovidiucristurean.shared.analytics.domain.time.MILLIS_PER_DAY
+
+/**
+ * One [ServiceTimeSketch] per UTC day of completion, for the in-memory repositories.
+ *
+ * Not thread-safe: callers hold the lock that guards their writes.
+ */
+internal class DailyServiceTimeSketches {
+    private val sketches = HashMap<Long, ServiceTimeSketch>()
+
+    fun add(lifecycle: ItemTagLifecycle) {
+        val day = lifecycle.completedAt.toEpochMilliseconds().floorDiv(MILLIS_PER_DAY)
+        sketches.getOrPut(day) { ServiceTimeSketch() }.add(lifecycle)
+    }
+
+    fun getStatistics(fromMillis: Long, toMillis: Long): ServiceTimeStatistics {
+        val merged = ServiceTimeSketch()
+        if (fromMillis <= toMillis) {
+            val days = fromMillis.floorDiv(MILLIS_PER_DAY)..toMillis.floorDiv(MILLIS_PER_DAY)
+            sketches.forEach { (day, sketch) -> if (day in days) merged.merge(sketch) }
+        }
+        return merged.toStatistics()
+    }
+}
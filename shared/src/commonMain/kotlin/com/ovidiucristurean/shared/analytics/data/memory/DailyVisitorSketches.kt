@@ -0,0 +1,25 @@
+package com.ovidiucristurean.shared.analytics.data.memory
+
+import com.ovidiucristurean.shared.analytics.domain.sketch.HyperLogLog
+import com.ovidiucristurean.shared.analytics.domain.time.MILLIS_PER_DAY
+
+/**
+ * One [HyperLogLog] of visitor keys per UTC day, for the in-memory repositories.
+ *
+ * Not thread-safe: callers hold the lock that guards their writes.
+ */
+internal class DailyVisitorSketches {
+    private val sketches = HashMap<Long, HyperLogLog>()
+
+    fun add(epochMillis: Long, visitorKey: String) {
+        sketches.getOrPut(epochMillis.floorDiv(MILLIS_PER_DAY)) { HyperLogLog() }.add(visitorKey)
+    }
+
+    fun countUniqueVisitors(fromMillis: Long, toMillis: Long): Long {
+        if (fromMillis > toMillis) return 0
+        val days = fromMillis.floorDiv(MILLIS_PER_DAY)..toMillis.floorDiv(MILLIS_PER_DAY)
+        val merged = HyperLogLog()
+        sketches.forEach { (day, sketch) -> if (day in days) merged.merge(sketch) }
+        return merged.estimate()
+    }
+}
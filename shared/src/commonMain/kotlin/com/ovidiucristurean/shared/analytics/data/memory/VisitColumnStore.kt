@@ -0,0 +1,140 @@
+package com.ovidiucristurean.shared.analytics.data.memory
+
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlin.concurrent.Volatile
+
+internal const val VISIT_COLUMN_CHUNK_SIZE = 4096
+
+/**
+ * Append-only visit log stored column-wise: timestamps go into [LongArray] chunks and shop ids
+ * are interned to [Int] codes in parallel [IntArray] chunks. A visit costs 12 bytes instead of a
+ * [VisitEvent] plus its `Instant`.
+ *
+ * Each chunk tracks its min and max timestamp, so range scans skip chunks outside the range.
+ * Visits usually arrive in time order, so that skips almost everything.
+ *
+ * Readers work on the published [ColumnSnapshot] without locking. Writers must be serialized by
+ * the caller.
+ */
+internal class VisitColumnStore {
+    // Both copy-on-write, so readers can resolve codes without locking.
+    @Volatile
+    private var codes = emptyMap<String, Int>()
+
+    @Volatile
+    private var shopIds = emptyList<String>()
+
+    @Volatile
+    private var current = ColumnSnapshot(
+        timestampChunks = emptyArray(),
+        shopCodeChunks = emptyArray(),
+        chunkMinMillis = LongArray(0),
+        chunkMaxMillis = LongArray(0),
+        size = 0
+    )
+
+    fun snapshot(): ColumnSnapshot = current
+
+    fun shopCodeOf(shopId: String): Int? = codes[shopId]
+
+    fun shopIdOf(shopCode: Int): String = shopIds[shopCode]
+
+    fun appendAll(events: List<VisitEvent>) {
+        val snapshot = current
+        var timestampChunks = snapshot.timestampChunks
+        var shopCodeChunks = snapshot.shopCodeChunks
+        var chunkMinMillis = snapshot.chunkMinMillis
+        var chunkMaxMillis = snapshot.chunkMaxMillis
+        var size = snapshot.size
+
+        events.forEach { event ->
+            val shopCode = codes[event.shopId] ?: intern(event.shopId)
+            val epochMillis = event.timestamp.toEpochMilliseconds()
+
+            val offset = size % VISIT_COLUMN_CHUNK_SIZE
+            if (offset == 0) {
+                // Published arrays are shared with readers, so growing them means copying.
+                val chunkCount = timestampChunks.size
+                timestampChunks = timestampChunks.plusElement(LongArray(VISIT_COLUMN_CHUNK_SIZE))
+                shopCodeChunks = shopCodeChunks.plusElement(IntArray(VISIT_COLUMN_CHUNK_SIZE))
+                chunkMinMillis = chunkMinMillis.copyOf(chunkCount + 1)
+                chunkMaxMillis = chunkMaxMillis.copyOf(chunkCount + 1)
+            }
+            val chunk = timestampChunks.lastIndex
+            timestampChunks[chunk][offset] = epochMillis
+            shopCodeChunks[chunk][offset] = shopCode
+            if (offset == 0 || epochMillis < chunkMinMillis[chunk]) chunkMinMillis[chunk] = epochMillis
+            if (offset == 0 || epochMillis > chunkMaxMillis[chunk]) chunkMaxMillis[chunk] = epochMillis
+            size++
+        }
+
+        current = ColumnSnapshot(
+            timestampChunks = timestampChunks,
+            shopCodeChunks = shopCodeChunks,
+            chunkMinMillis = chunkMinMillis,
+            chunkMaxMillis = chunkMaxMillis,
+            size = size
+        )
+    }
+
+    private fun intern(shopId: String): Int {
+        val shopCode = shopIds.size
+        shopIds = shopIds + shopId
+        codes = codes + (shopId to shopCode)
+        return shopCode
+    }
+}
+
+/**
+ * The first [size] visits of a [VisitColumnStore]. Entries below [size] are never modified.
+ */
+internal class ColumnSnapshot(
+    val timestampChunks: Array<LongArray>,
+    val shopCodeChunks: Array<IntArray>,
+    val chunkMinMillis: LongArray,
+    val chunkMaxMillis: LongArray,
+    val size: Int
+) {
+    fun count(shopCode: Int, fromMillis: Long, toMillis: Long): Int {
+        var count = 0
+        forEachInRange(shopCode, fromMillis, toMillis) { count++ }
+        return count
+    }
+
+    inline fun forEachInRange(
+        shopCode: Int,
+        fromMillis: Long,
+        toMillis: Long,
+        action: (epochMillis: Long) -> Unit
+    ) {
+        forEachInRange(fromMillis, toMillis) { code, millis -> if (code == shopCode) action(millis) }
+    }
+
+    // Visits at positions [startIndex] until [size], in the order they were appended.
+    inline fun forEachSince(startIndex: Int, action: (shopCode: Int, epochMillis: Long) -> Unit) {
+        for (index in startIndex until size) {
+            val chunk = index / VISIT_COLUMN_CHUNK_SIZE
+            val offset = index % VISIT_COLUMN_CHUNK_SIZE
+            action(shopCodeChunks[chunk][offset], timestampChunks[chunk][offset])
+        }
+    }
+
+    inline fun forEachInRange(
+        fromMillis: Long,
+        toMillis: Long,
+        action: (shopCode: Int, epochMillis: Long) -> Unit
+    ) {
+        for (chunk in timestampChunks.indices) {
+            val length = minOf(VISIT_COLUMN_CHUNK_SIZE, size - chunk * VISIT_COLUMN_CHUNK_SIZE)
+            if (length <= 0) break
+            if (chunkMaxMillis[chunk] < fromMillis || chunkMinMillis[chunk] > toMillis) continue
+
+            val timestamps = timestampChunks[chunk]
+            val shopCodes = shopCodeChunks[chunk]
+            for (index in 0 until length) {
+                val millis = timestamps[index]
+                if (millis in fromMillis..toMillis) action(shopCodes[index], millis)
+            }
+        }
+    }
+}
@@ -0,0 +1,114 @@
+package com.ovidiucristurean.shared.analytics.data.memory
+
+import kotlin.concurrent.Volatile
+
+/**
+ * Visit timestamps of a single shop, kept sorted in a growable [LongArray].
+ *
+ * Readers take a [snapshot] without locking. A published snapshot is never modified: in-order
+ * visits are written past its size before the next snapshot is published, and late visits are
+ * merged into a fresh array. Writers must be serialized by the caller.
+ */
+internal class VisitTimeline {
+    @Volatile
+    private var current = TimelineSnapshot(LongArray(INITIAL_CAPACITY), 0, 0)
+
+    fun snapshot(): TimelineSnapshot = current
+
+    fun add(epochMillis: LongArray) {
+        if (epochMillis.isEmpty()) return
+        epochMillis.sort()
+
+        val snapshot = current
+        val size = snapshot.size
+        current = if (size == 0 || snapshot[size - 1] <= epochMillis[0]) {
+            append(snapshot, epochMillis)
+        } else {
+            merge(snapshot, epochMillis)
+        }
+    }
+
+    private fun append(snapshot: TimelineSnapshot, sorted: LongArray): TimelineSnapshot {
+        val newSize = snapshot.size + sorted.size
+        val timestamps = if (newSize <= snapshot.timestamps.size) {
+            snapshot.timestamps
+        } else {
+            snapshot.timestamps.copyOf(grownCapacity(snapshot.timestamps.size, newSize))
+        }
+        sorted.copyInto(timestamps, snapshot.size)
+        return TimelineSnapshot(timestamps, newSize, snapshot.appendedFrom)
+    }
+
+    private fun merge(snapshot: TimelineSnapshot, sorted: LongArray): TimelineSnapshot {
+        val newSize = snapshot.size + sorted.size
+        val timestamps = LongArray(grownCapacity(snapshot.timestamps.size, newSize))
+        var existing = 0
+        var added = 0
+        for (index in 0 until newSize) {
+            timestamps[index] = if (
+                added == sorted.size ||
+                (existing < snapshot.size && snapshot[existing] <= sorted[added])
+            ) {
+                snapshot[existing++]
+            } else {
+                sorted[added++]
+            }
+        }
+        return TimelineSnapshot(timestamps, newSize, newSize)
+    }
+
+    private fun grownCapacity(capacity: Int, required: Int): Int {
+        var newCapacity = capacity.coerceAtLeast(INITIAL_CAPACITY)
+        while (newCapacity < required) newCapacity *= 2
+        return newCapacity
+    }
+
+    private companion object {
+        const val INITIAL_CAPACITY = 16
+    }
+}
+
+/**
+ * An immutable, sorted view of the first [size] entries of [timestamps].
+ *
+ * Entries from [appendedFrom] on were appended in the order they were added, so the visits added
+ * after a snapshot of size `n` are the entries from `n` on, as long as `n >= appendedFrom`.
+ */
+internal class TimelineSnapshot(
+    val timestamps: LongArray,
+    val size: Int,
+    val appendedFrom: Int
+) {
+    operator fun get(index: Int): Long = timestamps[index]
+
+    fun count(fromMillis: Long, toMillis: Long): Int =
+        maxOf(0, upperBound(toMillis) - lowerBound(fromMillis))
+
+    inline fun forEachInRange(fromMillis: Long, toMillis: Long, action: (Long) -> Unit) {
+        for (index in lowerBound(fromMillis) until upperBound(toMillis)) {
+            action(timestamps[index])
+        }
+    }
+
+    // Index of the first timestamp >= [epochMillis].
+    fun lowerBound(epochMillis: Long): Int {
+        var low = 0
+        var high = size
+        while (low < high) {
+            val mid = (low + high) ushr 1
+            if (timestamps[mid] < epochMillis) low = mid + 1 else high = mid
+        }
+        return low
+    }
+
+    // Index of the first timestamp > [epochMillis].
+    fun upperBound(epochMillis: Long): Int {
+        var low = 0
+        var high = size
+        while (low < high) {
+            val mid = (low + high) ushr 1
+            if (timestamps[mid] <= epochMillis) low = mid + 1 else high = mid
+        }
+        return low
+    }
+}
@@ -0,0 +1,237 @@
+package com.ovidiucristurean.shared.analytics.data.repository
+
+import com.ovidiucristurean.shared.analytics.data.memory.DailyServiceTimeSketches
+import com.ovidiucristurean.shared.analytics.data.memory.DailyVisitorSketches
+import com.ovidiucristurean.shared.analytics.data.memory.VisitColumnStore
+import com.ovidiucristurean.shared.analytics.domain.model.ItemTagLifecycle
+import com.ovidiucristurean.shared.analytics.domain.model.RecordedVisits
+import com.ovidiucristurean.shared.analytics.domain.model.ServiceTimeStatistics
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.time.DailyVisitBuckets
+import com.ovidiucristurean.shared.analytics.domain.time.HourOfWeekBuckets
+import com.ovidiucristurean.shared.analytics.domain.time.utcOffsetSegments
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
+
+/**
+ * Holds large visit histories in a [VisitColumnStore], at roughly 12 bytes per visit. Queries are
+ * scans over primitive columns that skip chunks outside the range, so it suits bulk statistics
+ * better than per-shop lookups, which [InMemoryAnalyticsRepository] does better.
+ */
+class ColumnarAnalyticsRepository : AnalyticsRepository {
+    private val store = VisitColumnStore()
+    private val writeMutex = Mutex()
+    private val version = MutableStateFlow(0L)
+    // Guarded by writeMutex.
+    private val visitors = HashMap<String, DailyVisitorSketches>()
+    // Guarded by writeMutex.
+    private val serviceTimes = HashMap<String, DailyServiceTimeSketches>()
+
+    override suspend fun recordVisit(event: VisitEvent) {
+        recordVisits(listOf(event))
+    }
+
+    override suspend fun recordVisits(events: List<VisitEvent>) {
+        writeMutex.withLock {
+            store.appendAll(events)
+            events.forEach { event ->
+                val visitorKey = event.visitorKey ?: return@forEach
+                visitors.getOrPut(event.shopId) { DailyVisitorSketches() }
+                    .add(event.timestamp.toEpochMilliseconds(), visitorKey)
+            }
+            version.value++
+        }
+    }
+
+    override suspend fun getVisits(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): List<VisitEvent> {
+        val shopCode = store.shopCodeOf(shopId) ?: return emptyList()
+        return buildList {
+            store.snapshot().forEachInRange(
+                shopCode,
+                from.toEpochMilliseconds(),
+                to.toEpochMilliseconds()
+            ) {
+                add(VisitEvent(shopId, Instant.fromEpochMilliseconds(it)))
+            }
+        }
+    }
+
+    // Pages follow insertion order, not time order: a late batch of older visits comes after
+    // the newer ones stored before it. No use case pages visits, and getVisitsRecordedAfter
+    // callers only bucket them, so nothing depends on the order.
+    override fun getVisitsPaged(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        pageSize: Int
+    ): Flow<List<VisitEvent>> = flow {
+        require(pageSize > 0) { "pageSize must be positive" }
+        val shopCode = store.shopCodeOf(shopId) ?: return@flow
+        var page = ArrayList<VisitEvent>(pageSize)
+        store.snapshot().forEachInRange(
+            shopCode,
+            from.toEpochMilliseconds(),
+            to.toEpochMilliseconds()
+        ) {
+            page.add(VisitEvent(shopId, Instant.fromEpochMilliseconds(it)))
+            if (page.size == pageSize) {
+                emit(page)
+                page = ArrayList(pageSize)
+            }
+        }
+        if (page.isNotEmpty()) emit(page)
+    }
+
+    override suspend fun countVisits(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Int {
+        val shopCode = store.shopCodeOf(shopId) ?: return 0
+        return store.snapshot().count(shopCode, from.toEpochMilliseconds(), to.toEpochMilliseconds())
+    }
+
+    // One scan over the whole span, routing each visit to its period by binary search.
+    override suspend fun countVisitsPerPeriod(
+        shopId: String,
+        boundaries: List<Instant>
+    ): IntArray {
+        val counts = IntArray(maxOf(0, boundaries.size - 1))
+        if (counts.isEmpty()) return counts
+        val shopCode = store.shopCodeOf(shopId) ?: return counts
+        val boundaryMillis = LongArray(boundaries.size) { boundaries[it].toEpochMilliseconds() }
+        store.snapshot().forEachInRange(
+            shopCode,
+            boundaryMillis.first(),
+            boundaryMillis.last() - 1
+        ) { millis ->
+            val found = boundaryMillis.binarySearch(millis)
+            // Equal boundaries make empty periods; a visit belongs to the last of them.
+            var period = if (found >= 0) found else -found - 2
+            while (period + 1 < counts.size && boundaryMillis[period + 1] <= millis) period++
+            counts[period]++
+        }
+        return counts
+    }
+
+    override suspend fun getDailyVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<LocalDate, Int> {
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        val shopCode = store.shopCodeOf(shopId) ?: return emptyMap()
+        val buckets = DailyVisitBuckets(timeZone.utcOffsetSegments(fromMillis, toMillis))
+        store.snapshot().forEachInRange(shopCode, fromMillis, toMillis) { buckets.addVisit(it) }
+        return buckets.nonZeroDays()
+    }
+
+    override suspend fun getHourOfWeekVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): IntArray {
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        val buckets = HourOfWeekBuckets(timeZone.utcOffsetSegments(fromMillis, toMillis))
+        val shopCode = store.shopCodeOf(shopId) ?: return buckets.toIntArray()
+        store.snapshot().forEachInRange(shopCode, fromMillis, toMillis) { buckets.addVisit(it) }
+        return buckets.toIntArray()
+    }
+
+    override suspend fun countUniqueVisitors(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Long = writeMutex.withLock {
+        visitors[shopId]?.countUniqueVisitors(from.toEpochMilliseconds(), to.toEpochMilliseconds())
+            ?: 0
+    }
+
+    override suspend fun recordItemTagLifecycles(lifecycles: List<ItemTagLifecycle>) {
+        writeMutex.withLock {
+            lifecycles.forEach { lifecycle ->
+                serviceTimes.getOrPut(lifecycle.shopId) { DailyServiceTimeSketches() }
+                    .add(lifecycle)
+            }
+        }
+    }
+
+    override suspend fun getServiceTimeStatistics(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): ServiceTimeStatistics = writeMutex.withLock {
+        serviceTimes[shopId]?.getStatistics(from.toEpochMilliseconds(), to.toEpochMilliseconds())
+            ?: ServiceTimeStatistics(createdToCompleted = null, readToCompleted = null)
+    }
+
+    // One scan over the range, routing each visit to its shop's buckets by shop code.
+    override suspend fun getDailyVisitCountsForShops(
+        shopIds: Collection<String>,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<String, Map<LocalDate, Int>> {
+        val snapshot = store.snapshot()
+        val shopCodes = shopIds.mapNotNull { store.shopCodeOf(it) }.distinct()
+        if (shopCodes.isEmpty()) return emptyMap()
+
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        val segments = timeZone.utcOffsetSegments(fromMillis, toMillis)
+        val buckets = arrayOfNulls<DailyVisitBuckets>(shopCodes.max() + 1)
+        shopCodes.forEach { buckets[it] = DailyVisitBuckets(segments) }
+        snapshot.forEachInRange(fromMillis, toMillis) { shopCode, millis ->
+            if (shopCode < buckets.size) buckets[shopCode]?.addVisit(millis)
+        }
+
+        return buildMap {
+            shopCodes.forEach { shopCode ->
+                val visitsPerDay = buckets[shopCode]?.nonZeroDays().orEmpty()
+                if (visitsPerDay.isNotEmpty()) put(store.shopIdOf(shopCode), visitsPerDay)
+            }
+        }
+    }
+
+    override fun observeVisitChanges(): Flow<Unit> = version.map { }
+
+    // The log is append-only, so its size is a watermark shared by every shop.
+    override suspend fun getWatermark(shopId: String): Long = store.snapshot().size.toLong()
+
+    override suspend fun getVisitsRecordedAfter(
+        shopId: String,
+        watermark: Long,
+        from: Instant,
+        to: Instant
+    ): RecordedVisits {
+        val snapshot = store.snapshot()
+        val shopCode = store.shopCodeOf(shopId)
+            ?: return RecordedVisits(emptyList(), snapshot.size.toLong())
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        val visits = buildList {
+            snapshot.forEachSince(watermark.toInt()) { code, millis ->
+                if (code == shopCode && millis in fromMillis..toMillis) {
+                    add(VisitEvent(shopId, Instant.fromEpochMilliseconds(millis)))
+                }
+            }
+        }
+        return RecordedVisits(visits, snapshot.size.toLong())
+    }
+}
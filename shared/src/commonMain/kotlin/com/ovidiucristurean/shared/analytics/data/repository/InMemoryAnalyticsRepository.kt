@@ -1,18 +1,60 @@
 package com.ovidiucristurean.shared.analytics.data.repository
 
+import com.ovidiucristurean.shared.analytics.data.memory.DailyServiceTimeSketches
+import com.ovidiucristurean.shared.analytics.data.memory.DailyVisitorSketches
+import com.ovidiucristurean.shared.analytics.data.memory.TimelineSnapshot
+import com.ovidiucristurean.shared.analytics.data.memory.VisitTimeline
+import com.ovidiucristurean.shared.analytics.domain.model.ItemTagLifecycle
+import com.ovidiucristurean.shared.analytics.domain.model.RecordedVisits
+import com.ovidiucristurean.shared.analytics.domain.model.ServiceTimeStatistics
 import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
 import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.time.DailyVisitBuckets
+import com.ovidiucristurean.shared.analytics.domain.time.HourOfWeekBuckets
+import com.ovidiucristurean.shared.analytics.domain.time.utcOffsetSegments
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.flow.update
 import kotlinx.coroutines.sync.Mutex
 import kotlinx.coroutines.sync.withLock
 import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
+import kotlin.concurrent.Volatile
 
+/**
+ * Keeps one sorted timestamp array per shop, so queries only touch the requested shop and
+ * find their range bounds by binary search.
+ *
+ * Each shop is its own shard with its own write lock, so writers to different shops never
+ * contend. Readers work on immutable snapshots and never take a lock, so a long query cannot
+ * hold up writers.
+ */
 class InMemoryAnalyticsRepository : AnalyticsRepository {
-    private val events = mutableListOf<VisitEvent>()
-    private val mutex = Mutex()
+    // Copy-on-write: replaced wholesale under shardsMutex when a new shop shows up.
+    @Volatile
+    private var shards = emptyMap<String, Shard>()
+    private val shardsMutex = Mutex()
+
+    // Bumped after every write; observers only care that it changed.
+    private val version = MutableStateFlow(0L)
+
+    // Item tags are rare next to visits, so one lock for all shops is enough.
+    private val serviceTimes = HashMap<String, DailyServiceTimeSketches>()
+    private val serviceTimesMutex = Mutex()
 
     override suspend fun recordVisit(event: VisitEvent) {
-        mutex.withLock {
-            events.add(event)
+        store(event.shopId, longArrayOf(event.timestamp.toEpochMilliseconds()), listOf(event))
+    }
+
+    override suspend fun recordVisits(events: List<VisitEvent>) {
+        events.groupBy { it.shopId }.forEach { (shopId, shopEvents) ->
+            val epochMillis = LongArray(shopEvents.size) {
+                shopEvents[it].timestamp.toEpochMilliseconds()
+            }
+            store(shopId, epochMillis, shopEvents)
         }
     }
 
@@ -21,10 +63,185 @@ class InMemoryAnalyticsRepository : AnalyticsRepository {
         from: Instant,
         to: Instant
     ): List<VisitEvent> {
-        return mutex.withLock {
-            events.filter {
-                it.shopId == shopId && it.timestamp >= from && it.timestamp <= to
+        val snapshot = snapshot(shopId) ?: return emptyList()
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        return buildList(snapshot.count(fromMillis, toMillis)) {
+            snapshot.forEachInRange(fromMillis, toMillis) {
+                add(VisitEvent(shopId, Instant.fromEpochMilliseconds(it)))
             }
         }
     }
+
+    override fun getVisitsPaged(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        pageSize: Int
+    ): Flow<List<VisitEvent>> = flow {
+        require(pageSize > 0) { "pageSize must be positive" }
+        val snapshot = snapshot(shopId) ?: return@flow
+        val end = snapshot.upperBound(to.toEpochMilliseconds())
+        var start = snapshot.lowerBound(from.toEpochMilliseconds())
+        while (start < end) {
+            val pageEnd = minOf(start + pageSize, end)
+            val offset = start
+            emit(
+                List(pageEnd - offset) {
+                    VisitEvent(shopId, Instant.fromEpochMilliseconds(snapshot[offset + it]))
+                }
+            )
+            start = pageEnd
+        }
+    }
+
+    override suspend fun countVisits(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Int {
+        return snapshot(shopId)?.count(from.toEpochMilliseconds(), to.toEpochMilliseconds()) ?: 0
+    }
+
+    // The timeline is sorted, so each period is the distance between two binary searches.
+    override suspend fun countVisitsPerPeriod(
+        shopId: String,
+        boundaries: List<Instant>
+    ): IntArray {
+        val counts = IntArray(maxOf(0, boundaries.size - 1))
+        val snapshot = snapshot(shopId) ?: return counts
+        var start = snapshot.lowerBound(boundaries.first().toEpochMilliseconds())
+        for (index in counts.indices) {
+            val end = snapshot.lowerBound(boundaries[index + 1].toEpochMilliseconds())
+            counts[index] = end - start
+            start = end
+        }
+        return counts
+    }
+
+    override suspend fun getDailyVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<LocalDate, Int> {
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        val buckets = DailyVisitBuckets(timeZone.utcOffsetSegments(fromMillis, toMillis))
+        snapshot(shopId)?.forEachInRange(fromMillis, toMillis) { buckets.addVisit(it) }
+        return buckets.nonZeroDays()
+    }
+
+    override suspend fun getHourOfWeekVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): IntArray {
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        val buckets = HourOfWeekBuckets(timeZone.utcOffsetSegments(fromMillis, toMillis))
+        snapshot(shopId)?.forEachInRange(fromMillis, toMillis) { buckets.addVisit(it) }
+        return buckets.toIntArray()
+    }
+
+    override suspend fun getDailyVisitCountsForShops(
+        shopIds: Collection<String>,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<String, Map<LocalDate, Int>> {
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        val segments = timeZone.utcOffsetSegments(fromMillis, toMillis)
+        return buildMap {
+            shopIds.forEach { shopId ->
+                val snapshot = snapshot(shopId) ?: return@forEach
+                val buckets = DailyVisitBuckets(segments)
+                snapshot.forEachInRange(fromMillis, toMillis) { buckets.addVisit(it) }
+                val visitsPerDay = buckets.nonZeroDays()
+                if (visitsPerDay.isNotEmpty()) put(shopId, visitsPerDay)
+            }
+        }
+    }
+
+    override fun observeVisitChanges(): Flow<Unit> = version.map { }
+
+    // The watermark is the size of the shop's timeline.
+    override suspend fun getWatermark(shopId: String): Long =
+        snapshot(shopId)?.size?.toLong() ?: 0L
+
+    override suspend fun getVisitsRecordedAfter(
+        shopId: String,
+        watermark: Long,
+        from: Instant,
+        to: Instant
+    ): RecordedVisits? {
+        val snapshot = snapshot(shopId) ?: return RecordedVisits(emptyList(), 0L)
+        // A late visit was merged into the middle of the timeline since the watermark.
+        if (watermark < snapshot.appendedFrom || watermark > snapshot.size) return null
+
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        val visits = buildList {
+            for (index in watermark.toInt() until snapshot.size) {
+                val millis = snapshot[index]
+                if (millis in fromMillis..toMillis) {
+                    add(VisitEvent(shopId, Instant.fromEpochMilliseconds(millis)))
+                }
+            }
+        }
+        return RecordedVisits(visits, snapshot.size.toLong())
+    }
+
+    override suspend fun countUniqueVisitors(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Long {
+        val shard = shards[shopId] ?: return 0
+        return shard.writeMutex.withLock {
+            shard.visitors.countUniqueVisitors(from.toEpochMilliseconds(), to.toEpochMilliseconds())
+        }
+    }
+
+    override suspend fun recordItemTagLifecycles(lifecycles: List<ItemTagLifecycle>) {
+        serviceTimesMutex.withLock {
+            lifecycles.forEach { lifecycle ->
+                serviceTimes.getOrPut(lifecycle.shopId) { DailyServiceTimeSketches() }
+                    .add(lifecycle)
+            }
+        }
+    }
+
+    override suspend fun getServiceTimeStatistics(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): ServiceTimeStatistics = serviceTimesMutex.withLock {
+        serviceTimes[shopId]?.getStatistics(from.toEpochMilliseconds(), to.toEpochMilliseconds())
+            ?: ServiceTimeStatistics(createdToCompleted = null, readToCompleted = null)
+    }
+
+    private fun snapshot(shopId: String): TimelineSnapshot? = shards[shopId]?.timeline?.snapshot()
+
+    private suspend fun store(shopId: String, epochMillis: LongArray, events: List<VisitEvent>) {
+        val shard = shards[shopId] ?: shardsMutex.withLock {
+            shards[shopId] ?: Shard().also { shards = shards + (shopId to it) }
+        }
+        shard.writeMutex.withLock {
+            shard.timeline.add(epochMillis)
+            events.forEachIndexed { index, event ->
+                event.visitorKey?.let { shard.visitors.add(epochMillis[index], it) }
+            }
+        }
+        version.update { it + 1 }
+    }
+
+    private class Shard {
+        val timeline = VisitTimeline()
+        val writeMutex = Mutex()
+        // Guarded by writeMutex, unlike the timeline, whose snapshots are read without a lock.
+        val visitors = DailyVisitorSketches()
+    }
 }
@@ -0,0 +1,242 @@
+package com.ovidiucristurean.shared.analytics.data.repository
+
+import com.ovidiucristurean.shared.analytics.data.journal.JournalRecord
+import com.ovidiucristurean.shared.analytics.data.journal.VisitJournal
+import com.ovidiucristurean.shared.analytics.domain.model.ItemTagLifecycle
+import com.ovidiucristurean.shared.analytics.domain.model.RecordedVisits
+import com.ovidiucristurean.shared.analytics.domain.model.ServiceTimeStatistics
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.sketch.HyperLogLog
+import com.ovidiucristurean.shared.analytics.logMessage
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.emitAll
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import kotlinx.coroutines.withTimeoutOrNull
+import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.seconds
+
+/**
+ * Puts a [VisitJournal] in front of [room]. Recording a batch is a single synced file append
+ * instead of a SQLite transaction. A background drainer moves sealed journal segments into
+ * `visit_events` in large transactions and deletes them once applied.
+ *
+ * Records carry a hash of the visitor key, if any. Each segment's visits and visitor sketches are
+ * applied together with a checkpoint in the database, so replaying the journal after a crash,
+ * whether the segment was applied or not, never stores a visit twice. Reads
+ * drain first, so they always see every recorded visit.
+ */
+internal class JournaledAnalyticsRepository(
+    private val room: RoomAnalyticsRepository,
+    private val journal: VisitJournal,
+    scope: CoroutineScope,
+    private val ioDispatcher: CoroutineDispatcher,
+    private val drainThreshold: Int = DEFAULT_DRAIN_THRESHOLD,
+    private val drainInterval: Duration = DEFAULT_DRAIN_INTERVAL
+) : AnalyticsRepository {
+    private val journalMutex = Mutex()
+    private val drainMutex = Mutex()
+    private val drainRequests = Channel<Unit>(Channel.CONFLATED)
+    private var isJournalOpen = false
+    private var pendingRecords = 0
+    // Starts out true so that the first drain replays what an earlier process left behind.
+    private var hasSealedSegments = true
+
+    init {
+        scope.launch { drainContinuously() }
+    }
+
+    override suspend fun recordVisit(event: VisitEvent) {
+        recordVisits(listOf(event))
+    }
+
+    override suspend fun recordVisits(events: List<VisitEvent>) {
+        if (events.isEmpty()) return
+        val keys = room.getOrCreateShopKeys(events.mapTo(HashSet()) { it.shopId })
+        val records = events.map { event ->
+            JournalRecord(
+                shopKey = keys.getValue(event.shopId),
+                epochMillis = event.timestamp.toEpochMilliseconds(),
+                visitorHash = event.visitorKey?.let { HyperLogLog.hashOf(it) }
+            )
+        }
+        val pending = journalMutex.withLock {
+            openJournal()
+            withContext(ioDispatcher) { journal.append(records) }
+            pendingRecords += records.size
+            pendingRecords
+        }
+        if (pending >= drainThreshold) drainRequests.trySend(Unit)
+    }
+
+    override suspend fun getVisits(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): List<VisitEvent> {
+        drain()
+        return room.getVisits(shopId, from, to)
+    }
+
+    override fun getVisitsPaged(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        pageSize: Int
+    ): Flow<List<VisitEvent>> = flow {
+        drain()
+        emitAll(room.getVisitsPaged(shopId, from, to, pageSize))
+    }
+
+    override suspend fun countVisits(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Int {
+        drain()
+        return room.countVisits(shopId, from, to)
+    }
+
+    override suspend fun countVisitsPerPeriod(
+        shopId: String,
+        boundaries: List<Instant>
+    ): IntArray {
+        drain()
+        return room.countVisitsPerPeriod(shopId, boundaries)
+    }
+
+    override suspend fun getDailyVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<LocalDate, Int> {
+        drain()
+        return room.getDailyVisitCounts(shopId, from, to, timeZone)
+    }
+
+    override suspend fun getDailyVisitCountsForShops(
+        shopIds: Collection<String>,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<String, Map<LocalDate, Int>> {
+        drain()
+        return room.getDailyVisitCountsForShops(shopIds, from, to, timeZone)
+    }
+
+    override suspend fun getHourOfWeekVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): IntArray {
+        drain()
+        return room.getHourOfWeekVisitCounts(shopId, from, to, timeZone)
+    }
+
+    override suspend fun countUniqueVisitors(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Long {
+        drain()
+        return room.countUniqueVisitors(shopId, from, to)
+    }
+
+    // Item tags are rare next to visits and never go through the journal.
+    override suspend fun recordItemTagLifecycles(lifecycles: List<ItemTagLifecycle>) {
+        room.recordItemTagLifecycles(lifecycles)
+    }
+
+    override suspend fun getServiceTimeStatistics(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): ServiceTimeStatistics = room.getServiceTimeStatistics(shopId, from, to)
+
+    // Room reports the drainer's writes, so observers still see every recorded visit.
+    override fun observeVisitChanges(): Flow<Unit> = room.observeVisitChanges()
+
+    override suspend fun getWatermark(shopId: String): Long {
+        drain()
+        return room.getWatermark(shopId)
+    }
+
+    override suspend fun getVisitsRecordedAfter(
+        shopId: String,
+        watermark: Long,
+        from: Instant,
+        to: Instant
+    ): RecordedVisits {
+        drain()
+        return room.getVisitsRecordedAfter(shopId, watermark, from, to)
+    }
+
+    /**
+     * Applies every journaled visit to the database.
+     */
+    suspend fun drain() {
+        drainMutex.withLock {
+            val segments = journalMutex.withLock {
+                if (pendingRecords == 0 && !hasSealedSegments) return
+                openJournal()
+                pendingRecords = 0
+                hasSealedSegments = true
+                withContext(ioDispatcher) {
+                    journal.seal()
+                    journal.sealedSegments()
+                }
+            }
+
+            val lastApplied = room.getLastAppliedJournalSegment()
+            segments.forEach { segment ->
+                // Segments up to the checkpoint were applied before a crash kept them from being
+                // deleted.
+                if (segment.id > lastApplied) {
+                    val records = withContext(ioDispatcher) { journal.read(segment) }
+                    room.applyJournalSegment(segment.id, records)
+                }
+                withContext(ioDispatcher) { journal.delete(segment) }
+            }
+            hasSealedSegments = false
+        }
+    }
+
+    private suspend fun drainContinuously() {
+        while (true) {
+            try {
+                drain()
+            } catch (e: CancellationException) {
+                throw e
+            } catch (e: Exception) {
+                // The records stay in the journal and the next drain retries them.
+                logMessage("Failed to drain the visit journal: ${e.message}")
+            }
+            withTimeoutOrNull(drainInterval) { drainRequests.receive() }
+        }
+    }
+
+    private suspend fun openJournal() {
+        if (isJournalOpen) return
+        val lastApplied = room.getLastAppliedJournalSegment()
+        withContext(ioDispatcher) { journal.open(minSegmentId = lastApplied) }
+        isJournalOpen = true
+    }
+
+    companion object {
+        const val DEFAULT_DRAIN_THRESHOLD = 4096
+        val DEFAULT_DRAIN_INTERVAL = 5.seconds
+    }
+}
@@ -1,24 +1,104 @@
 package com.ovidiucristurean.shared.analytics.data.repository
 
-import com.benasher44.uuid.uuid4
+import com.ovidiucristurean.shared.analytics.data.journal.JournalRecord
 import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsDatabase
+import com.ovidiucristurean.shared.analytics.data.local.entity.JournalCheckpointEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.RetentionStateEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDailyServiceTimesEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDailyVisitorsEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.ShopDailyVisitsEntity
 import com.ovidiucristurean.shared.analytics.data.local.entity.VisitEventEntity
+import com.ovidiucristurean.shared.analytics.data.local.entity.toSketch
+import com.ovidiucristurean.shared.analytics.domain.model.ItemTagLifecycle
+import com.ovidiucristurean.shared.analytics.domain.model.RecordedVisits
+import com.ovidiucristurean.shared.analytics.domain.model.ServiceTimeStatistics
 import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
 import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.sketch.HyperLogLog
+import com.ovidiucristurean.shared.analytics.domain.sketch.ServiceTimeSketch
+import com.ovidiucristurean.shared.analytics.domain.time.DailyVisitBuckets
+import com.ovidiucristurean.shared.analytics.domain.time.HourOfWeekBuckets
+import com.ovidiucristurean.shared.analytics.domain.time.utcOffsetSegments
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.datetime.DateTimeUnit
 import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
+import kotlinx.datetime.atStartOfDayIn
+import kotlinx.datetime.minus
+import kotlinx.datetime.plus
+import kotlinx.datetime.toLocalDateTime
+import kotlin.concurrent.Volatile
 
+/**
+ * Stores raw visits in `visit_events` and keeps the `shop_daily_visits` rollup up to date in
+ * the same transaction. Rollup days are local days in [rollupTimeZone]. Whole days are read
+ * from the rollup, so statistics cost does not grow with the number of raw visits. Only the
+ * partial days at either end of a range are counted from raw rows.
+ *
+ * Visitor keys are never stored. Each one is added to a HyperLogLog sketch of its shop and rollup
+ * day in `shop_daily_visitors`, written in the same transaction as the visits. Item tag service
+ * times are likewise kept only as t-digests per shop and rollup day of completion, in
+ * `shop_daily_service_times`.
+ *
+ * Shop ids are stored as integer keys from `shops_dict`. The mapping is cached in memory, so once
+ * a shop has been seen, recording its visits never touches the dictionary table.
+ *
+ * Raw visits older than the retention horizon may have been purged by `VisitRetentionEngine`.
+ * Before the horizon, counts come from the rollup alone, so range edges there are rounded out to
+ * whole rollup days, and days in another time zone are approximated by the rollup days.
+ *
+ * The zone the rollup was built in is kept in `rollup_state`. If it is missing or differs from
+ * [rollupTimeZone], the rollup is rebuilt from the raw rows before the first read or write. Days
+ * before the horizon, and the visitor and service time sketches, keep the days they were
+ * recorded in, and the horizon moves to the next day start in the new zone.
+ */
 class RoomAnalyticsRepository(
-    database: AnalyticsDatabase
+    private val database: AnalyticsDatabase,
+    private val rollupTimeZone: TimeZone = TimeZone.UTC
 ) : AnalyticsRepository {
     private val dao = database.visitEventDao()
 
+    private val shopKeysMutex = Mutex()
+    @Volatile
+    private var shopKeys: Map<String, Long> = emptyMap()
+    private var isShopKeysLoaded = false
+
+    private val rollupCheckMutex = Mutex()
+    @Volatile
+    private var isRollupChecked = false
+
+    private val rawHorizonMutex = Mutex()
+    @Volatile
+    private var rawHorizon: Long? = null
+
     override suspend fun recordVisit(event: VisitEvent) {
-        dao.insert(
-            VisitEventEntity(
-                id = uuid4().toString(),
-                shopId = event.shopId,
-                timestampEpochMillis = event.timestamp.toEpochMilliseconds()
-            )
+        recordVisits(listOf(event))
+    }
+
+    override suspend fun recordVisits(events: List<VisitEvent>) {
+        if (events.isEmpty()) return
+        // A rebuild after this insert would count it again, so it has to happen first.
+        ensureDailyVisits()
+        val keys = getOrCreateShopKeys(events.mapTo(HashSet()) { it.shopId })
+        val entities = events.map { it.toEntity(keys.getValue(it.shopId)) }
+        val visitors = events.mapNotNull { event ->
+            event.visitorKey?.let {
+                JournalRecord(
+                    shopKey = keys.getValue(event.shopId),
+                    epochMillis = event.timestamp.toEpochMilliseconds(),
+                    visitorHash = HyperLogLog.hashOf(it)
+                )
+            }
+        }
+        dao.insertAllWithDailyStats(
+            events = entities,
+            dailyVisits = entities.toDailyVisits(),
+            dailyVisitors = visitors.toDailyVisitors()
         )
     }
 
@@ -27,15 +107,562 @@ class RoomAnalyticsRepository(
         from: Instant,
         to: Instant
     ): List<VisitEvent> {
+        val shopKey = findShopKey(shopId) ?: return emptyList()
         return dao.getVisits(
-            shopId = shopId,
+            shopKey = shopKey,
             from = from.toEpochMilliseconds(),
             to = to.toEpochMilliseconds()
         ).map {
             VisitEvent(
-                shopId = it.shopId,
+                shopId = shopId,
                 timestamp = Instant.fromEpochMilliseconds(it.timestampEpochMillis)
             )
         }
     }
+
+    override fun getVisitsPaged(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        pageSize: Int
+    ): Flow<List<VisitEvent>> = flow {
+        require(pageSize > 0) { "pageSize must be positive" }
+        val shopKey = findShopKey(shopId) ?: return@flow
+        val toMillis = to.toEpochMilliseconds()
+        var afterMillis = from.toEpochMilliseconds()
+        var afterId = 0L // Row ids start at 1, so the first page includes rows at [from].
+
+        while (true) {
+            val page = dao.getVisitsPage(shopKey, afterMillis, afterId, toMillis, pageSize)
+            if (page.isEmpty()) break
+            emit(
+                page.map { VisitEvent(shopId, Instant.fromEpochMilliseconds(it.timestampEpochMillis)) }
+            )
+            if (page.size < pageSize) break
+            afterMillis = page.last().timestampEpochMillis
+            afterId = page.last().id
+        }
+    }
+
+    override suspend fun countVisits(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Int {
+        val shopKey = findShopKey(shopId) ?: return 0
+        ensureDailyVisits()
+        val split = splitByRollupDays(
+            from.toEpochMilliseconds(),
+            to.toEpochMilliseconds(),
+            getRawHorizon()
+        )
+
+        var count = split.days?.let { dao.sumDailyVisits(shopKey, it.first, it.last) } ?: 0
+        split.head?.let { count += dao.countVisits(shopKey, it.first, it.last) }
+        split.tail?.let { count += dao.countVisits(shopKey, it.first, it.last) }
+        return count
+    }
+
+    // One grouped read of the rollup covers every whole day the periods span. Only the days that
+    // a boundary cuts in two are counted from raw rows.
+    override suspend fun countVisitsPerPeriod(
+        shopId: String,
+        boundaries: List<Instant>
+    ): IntArray {
+        val counts = IntArray(maxOf(0, boundaries.size - 1))
+        if (counts.isEmpty()) return counts
+        val shopKey = findShopKey(shopId) ?: return counts
+        ensureDailyVisits()
+        val rawHorizon = getRawHorizon()
+        val boundaryMillis = boundaries.map { it.toEpochMilliseconds() }
+        val firstDay = boundaryMillis.first().toRollupEpochDay()
+        val visitsPerDay = dao.getDailyVisits(
+            shopKey = shopKey,
+            fromDay = firstDay,
+            toDay = boundaryMillis.last().toRollupEpochDay()
+        ).associate { it.epochDay to it.visitCount }
+
+        // Visits from the start of the first day up to each boundary.
+        var day = firstDay
+        var wholeDayVisits = 0
+        val visitsBefore = boundaryMillis.map { boundary ->
+            val boundaryDay = boundary.toRollupEpochDay()
+            while (day < boundaryDay) wholeDayVisits += visitsPerDay[day++] ?: 0
+            val dayStart = boundary.toRollupDate().startMillis()
+            // The horizon is a day start, so a boundary before it is on a purged day and is
+            // rounded down to the start of that day.
+            if (boundary == dayStart || boundary < rawHorizon) {
+                wholeDayVisits
+            } else {
+                wholeDayVisits + dao.countVisits(shopKey, dayStart, boundary - 1)
+            }
+        }
+        for (index in counts.indices) counts[index] = visitsBefore[index + 1] - visitsBefore[index]
+        return counts
+    }
+
+    override suspend fun getDailyVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<LocalDate, Int> {
+        val shopKey = findShopKey(shopId) ?: return emptyMap()
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        val buckets = DailyVisitBuckets(timeZone.utcOffsetSegments(fromMillis, toMillis))
+
+        val rawHorizon = getRawHorizon()
+
+        if (timeZone.id != rollupTimeZone.id) {
+            if (fromMillis < rawHorizon) {
+                ensureDailyVisits()
+                purgedDayRange(fromMillis, toMillis, rawHorizon, buckets)?.let { days ->
+                    dao.getDailyVisits(shopKey, days.first, days.last)
+                        .forEach { buckets.addVisits(it.epochDay, it.visitCount) }
+                }
+            }
+            addRawDailyVisits(buckets, shopKey, maxOf(fromMillis, rawHorizon)..toMillis, timeZone)
+            return buckets.nonZeroDays()
+        }
+
+        ensureDailyVisits()
+        val split = splitByRollupDays(fromMillis, toMillis, rawHorizon)
+        split.head?.let { addRawDailyVisits(buckets, shopKey, it, timeZone) }
+        split.days?.let { days ->
+            dao.getDailyVisits(shopKey, days.first, days.last)
+                .forEach { buckets.addVisits(it.epochDay, it.visitCount) }
+        }
+        split.tail?.let { addRawDailyVisits(buckets, shopKey, it, timeZone) }
+        return buckets.nonZeroDays()
+    }
+
+    override suspend fun getDailyVisitCountsForShops(
+        shopIds: Collection<String>,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<String, Map<LocalDate, Int>> {
+        val shopIdsByKey = buildMap {
+            shopIds.forEach { shopId -> findShopKey(shopId)?.let { put(it, shopId) } }
+        }
+        if (shopIdsByKey.isEmpty()) return emptyMap()
+        val shopKeys = shopIdsByKey.keys.toList()
+        val fromMillis = from.toEpochMilliseconds()
+        val toMillis = to.toEpochMilliseconds()
+        val segments = timeZone.utcOffsetSegments(fromMillis, toMillis)
+        val buckets = shopKeys.associateWith { DailyVisitBuckets(segments) }
+        val rawHorizon = getRawHorizon()
+
+        if (timeZone.id != rollupTimeZone.id) {
+            if (fromMillis < rawHorizon) {
+                ensureDailyVisits()
+                val anyBuckets = buckets.values.first()
+                purgedDayRange(fromMillis, toMillis, rawHorizon, anyBuckets)?.let { days ->
+                    dao.getDailyVisitsForShops(shopKeys, days.first, days.last)
+                        .forEach { buckets.getValue(it.shopKey).addVisits(it.day, it.count) }
+                }
+            }
+            addRawDailyVisits(buckets, maxOf(fromMillis, rawHorizon)..toMillis, timeZone)
+        } else {
+            ensureDailyVisits()
+            val split = splitByRollupDays(fromMillis, toMillis, rawHorizon)
+            split.head?.let { addRawDailyVisits(buckets, it, timeZone) }
+            split.days?.let { days ->
+                dao.getDailyVisitsForShops(shopKeys, days.first, days.last)
+                    .forEach { buckets.getValue(it.shopKey).addVisits(it.day, it.count) }
+            }
+            split.tail?.let { addRawDailyVisits(buckets, it, timeZone) }
+        }
+
+        return buildMap {
+            buckets.forEach { (shopKey, shopBuckets) ->
+                val visitsPerDay = shopBuckets.nonZeroDays()
+                if (visitsPerDay.isNotEmpty()) put(shopIdsByKey.getValue(shopKey), visitsPerDay)
+            }
+        }
+    }
+
+    // Hours are only known from raw rows, so visits before the retention horizon are left out.
+    override suspend fun getHourOfWeekVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): IntArray {
+        val buckets = HourOfWeekBuckets(emptyList())
+        val shopKey = findShopKey(shopId) ?: return buckets.toIntArray()
+        val fromMillis = maxOf(from.toEpochMilliseconds(), getRawHorizon())
+        timeZone.utcOffsetSegments(fromMillis, to.toEpochMilliseconds()).forEach { segment ->
+            dao.countVisitsPerHourOfWeek(
+                shopKey = shopKey,
+                from = segment.fromEpochMillis,
+                to = segment.toEpochMillis,
+                offsetMillis = segment.offsetMillis
+            ).forEach { buckets.addVisits(it.hourOfWeek, it.visitCount) }
+        }
+        return buckets.toIntArray()
+    }
+
+    override suspend fun countUniqueVisitors(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Long {
+        if (from > to) return 0
+        val shopKey = findShopKey(shopId) ?: return 0
+        val merged = HyperLogLog()
+        dao.getDailyVisitorSketches(
+            shopKey = shopKey,
+            fromDay = from.toEpochMilliseconds().toRollupDate().toEpochDays().toLong(),
+            toDay = to.toEpochMilliseconds().toRollupDate().toEpochDays().toLong()
+        ).forEach { merged.merge(HyperLogLog.fromByteArray(it)) }
+        return merged.estimate()
+    }
+
+    override suspend fun recordItemTagLifecycles(lifecycles: List<ItemTagLifecycle>) {
+        if (lifecycles.isEmpty()) return
+        val keys = getOrCreateShopKeys(lifecycles.mapTo(HashSet()) { it.shopId })
+        val segments = rollupTimeZone.utcOffsetSegments(
+            lifecycles.minOf { it.completedAt.toEpochMilliseconds() },
+            lifecycles.maxOf { it.completedAt.toEpochMilliseconds() }
+        )
+        val sketches = mutableMapOf<Pair<Long, Long>, ServiceTimeSketch>()
+        lifecycles.forEach { lifecycle ->
+            val millis = lifecycle.completedAt.toEpochMilliseconds()
+            val day = segments.first { millis <= it.toEpochMillis }.epochDayOf(millis)
+            sketches.getOrPut(keys.getValue(lifecycle.shopId) to day) { ServiceTimeSketch() }
+                .add(lifecycle)
+        }
+        dao.mergeDailyServiceTimes(
+            sketches.map { (key, sketch) ->
+                ShopDailyServiceTimesEntity(
+                    shopKey = key.first,
+                    day = key.second,
+                    createdToCompleted = sketch.createdToCompleted.toByteArray(),
+                    readToCompleted = sketch.readToCompleted.toByteArray()
+                )
+            }
+        )
+    }
+
+    override suspend fun getServiceTimeStatistics(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): ServiceTimeStatistics {
+        val merged = ServiceTimeSketch()
+        val shopKey = findShopKey(shopId)
+        if (shopKey != null && from <= to) {
+            dao.getDailyServiceTimesInRange(
+                shopKey = shopKey,
+                fromDay = from.toEpochMilliseconds().toRollupDate().toEpochDays().toLong(),
+                toDay = to.toEpochMilliseconds().toRollupDate().toEpochDays().toLong()
+            ).forEach { merged.merge(it.toSketch()) }
+        }
+        return merged.toStatistics()
+    }
+
+    override fun observeVisitChanges(): Flow<Unit> =
+        database.invalidationTracker.createFlow("visit_events").map { }
+
+    // Row ids are global, so the watermark is the same for every shop.
+    override suspend fun getWatermark(shopId: String): Long = dao.getMaxVisitId()
+
+    override suspend fun getVisitsRecordedAfter(
+        shopId: String,
+        watermark: Long,
+        from: Instant,
+        to: Instant
+    ): RecordedVisits {
+        // Bounding the query by a watermark read first means a concurrent write is either
+        // fully in this result or fully in the next one.
+        val upToId = dao.getMaxVisitId()
+        val shopKey = findShopKey(shopId) ?: return RecordedVisits(emptyList(), upToId)
+        val visits = dao.getVisitsRecordedBetween(
+            shopKey = shopKey,
+            afterId = watermark,
+            upToId = upToId,
+            from = from.toEpochMilliseconds(),
+            to = to.toEpochMilliseconds()
+        ).map { VisitEvent(shopId, Instant.fromEpochMilliseconds(it.timestampEpochMillis)) }
+        return RecordedVisits(visits, upToId)
+    }
+
+    internal suspend fun getLastAppliedJournalSegment(): Long =
+        dao.getLastAppliedJournalSegment() ?: 0L
+
+    /**
+     * Stores the records of journal segment [segmentId], adds their visitor hashes to the daily
+     * sketches and moves the checkpoint past it, all in one transaction.
+     */
+    internal suspend fun applyJournalSegment(segmentId: Long, records: List<JournalRecord>) {
+        ensureDailyVisits()
+        val entities = records.map {
+            VisitEventEntity(shopKey = it.shopKey, timestampEpochMillis = it.epochMillis)
+        }
+        dao.insertJournalSegment(
+            events = entities,
+            dailyVisits = if (entities.isEmpty()) emptyList() else entities.toDailyVisits(),
+            dailyVisitors = records.toDailyVisitors(),
+            checkpoint = JournalCheckpointEntity(lastAppliedSegment = segmentId)
+        )
+    }
+
+    /**
+     * Recomputes the daily rollup from the raw rows in [rollupTimeZone] and records that zone.
+     * Days before the retention horizon have no raw rows left and are kept as they are.
+     *
+     * The horizon is a day start in the zone the rollup was built in. Its rows for the days before
+     * the horizon are kept, and the horizon moves forward to the next day start in
+     * [rollupTimeZone]. Reads before it then use the rollup alone, whose day at the seam holds the
+     * purged visits of the old day and the raw ones up to the new horizon.
+     */
+    suspend fun rebuildDailyVisits() {
+        rawHorizonMutex.withLock {
+            val horizon = loadRawHorizon()
+            if (horizon == NO_RAW_HORIZON) {
+                dao.rebuildDailyVisits(rollupTimeZone, keepBeforeDay = Long.MIN_VALUE, horizon)
+                return
+            }
+            val builtIn = dao.getRollupTimeZoneId()?.let { TimeZone.of(it) } ?: rollupTimeZone
+            val horizonDate = horizon.toRollupDate()
+            val newHorizon = if (horizonDate.startMillis() == horizon) {
+                horizon
+            } else {
+                horizonDate.plus(1, DateTimeUnit.DAY).startMillis()
+            }
+            dao.rebuildDailyVisits(
+                timeZone = rollupTimeZone,
+                keepBeforeDay = Instant.fromEpochMilliseconds(horizon).toLocalDateTime(builtIn)
+                    .date.toEpochDays().toLong(),
+                fromMillis = horizon,
+                retentionState = RetentionStateEntity(rawHorizonMillis = newHorizon)
+                    .takeIf { newHorizon != horizon }
+            )
+            rawHorizon = newHorizon
+        }
+    }
+
+    /**
+     * Moves the retention horizon forward to the start of the rollup day containing [before], and
+     * returns the horizon now in effect. From then on, statistics before the horizon are read
+     * from the rollup only, so the raw rows there can be deleted without changing any result.
+     */
+    internal suspend fun advanceRawHorizon(before: Instant): Long {
+        // The rollup must hold every purged row before the first one is deleted.
+        ensureDailyVisits()
+        val horizon = before.toEpochMilliseconds().toRollupDate().startMillis()
+        return rawHorizonMutex.withLock {
+            val current = loadRawHorizon()
+            if (horizon > current) {
+                dao.setRetentionState(RetentionStateEntity(rawHorizonMillis = horizon))
+                rawHorizon = horizon
+            }
+            maxOf(horizon, current)
+        }
+    }
+
+    /**
+     * Deletes up to [limit] raw visits from before [rawHorizon] and returns how many were deleted.
+     * Throws IllegalStateException, deleting nothing, if the rollup does not hold their days.
+     */
+    internal suspend fun deleteRawVisitsBefore(rawHorizon: Long, limit: Int): Int {
+        require(rawHorizon <= getRawHorizon()) { "Raw visits after the horizon must be kept" }
+        return dao.deleteRolledUpVisitsBefore(rollupTimeZone, rawHorizon, limit)
+    }
+
+    private suspend fun findShopKey(shopId: String): Long? {
+        shopKeys[shopId]?.let { return it }
+        return shopKeysMutex.withLock {
+            loadShopKeys()
+            shopKeys[shopId]
+        }
+    }
+
+    internal suspend fun getOrCreateShopKeys(shopIds: Set<String>): Map<String, Long> {
+        val cached = shopKeys
+        if (cached.keys.containsAll(shopIds)) return cached
+        return shopKeysMutex.withLock {
+            loadShopKeys()
+            val missing = shopIds - shopKeys.keys
+            if (missing.isNotEmpty()) {
+                shopKeys = shopKeys + dao.getOrCreateShopKeys(missing)
+            }
+            shopKeys
+        }
+    }
+
+    // Reads the whole dictionary on the first miss; it has one row per shop, so it stays small.
+    private suspend fun loadShopKeys() {
+        if (isShopKeysLoaded) return
+        shopKeys = shopKeys + dao.getShops().associate { it.externalId to it.id }
+        isShopKeysLoaded = true
+    }
+
+    // Databases migrated from before the rollup existed, or last opened with another rollup time
+    // zone, have no daily rows for [rollupTimeZone] yet. Checked once per repository.
+    private suspend fun ensureDailyVisits() {
+        if (isRollupChecked) return
+        rollupCheckMutex.withLock {
+            if (isRollupChecked) return
+            if (dao.getRollupTimeZoneId() != rollupTimeZone.id) rebuildDailyVisits()
+            isRollupChecked = true
+        }
+    }
+
+    private suspend fun getRawHorizon(): Long =
+        rawHorizon ?: rawHorizonMutex.withLock { loadRawHorizon() }
+
+    private suspend fun loadRawHorizon(): Long =
+        rawHorizon ?: (dao.getRawHorizon() ?: NO_RAW_HORIZON).also { rawHorizon = it }
+
+    // The rollup days before the horizon that fall within both the range and the buckets.
+    private fun purgedDayRange(
+        fromMillis: Long,
+        toMillis: Long,
+        rawHorizon: Long,
+        buckets: DailyVisitBuckets
+    ): LongRange? {
+        val first = maxOf(fromMillis.toRollupDate().toEpochDays().toLong(), buckets.epochDays.first)
+        val last = minOf(
+            minOf(toMillis, rawHorizon - 1).toRollupDate().toEpochDays().toLong(),
+            buckets.epochDays.last
+        )
+        return if (first <= last) first..last else null
+    }
+
+    private suspend fun addRawDailyVisits(
+        buckets: DailyVisitBuckets,
+        shopKey: Long,
+        range: LongRange,
+        timeZone: TimeZone
+    ) {
+        timeZone.utcOffsetSegments(range.first, range.last).forEach { segment ->
+            dao.countVisitsPerDay(
+                shopKey = shopKey,
+                from = segment.fromEpochMillis,
+                to = segment.toEpochMillis,
+                offsetMillis = segment.offsetMillis
+            ).forEach { buckets.addVisits(it.epochDay, it.visitCount) }
+        }
+    }
+
+    private suspend fun addRawDailyVisits(
+        buckets: Map<Long, DailyVisitBuckets>,
+        range: LongRange,
+        timeZone: TimeZone
+    ) {
+        timeZone.utcOffsetSegments(range.first, range.last).forEach { segment ->
+            dao.countVisitsPerDayForShops(
+                shopKeys = buckets.keys.toList(),
+                from = segment.fromEpochMillis,
+                to = segment.toEpochMillis,
+                offsetMillis = segment.offsetMillis
+            ).forEach { buckets.getValue(it.shopKey).addVisits(it.day, it.count) }
+        }
+    }
+
+    // Raw rows before the horizon may be gone, so range edges there are rounded out to whole days.
+    private fun splitByRollupDays(fromMillis: Long, toMillis: Long, rawHorizon: Long): RollupSplit {
+        if (fromMillis > toMillis) return RollupSplit(head = null, days = null, tail = null)
+        return splitByWholeDays(
+            fromMillis = if (fromMillis < rawHorizon) {
+                fromMillis.toRollupDate().startMillis()
+            } else {
+                fromMillis
+            },
+            toMillis = if (toMillis < rawHorizon) {
+                toMillis.toRollupDate().plus(1, DateTimeUnit.DAY).startMillis() - 1
+            } else {
+                toMillis
+            }
+        )
+    }
+
+    private fun splitByWholeDays(fromMillis: Long, toMillis: Long): RollupSplit {
+        val fromDate = fromMillis.toRollupDate()
+        val firstFullDate = if (fromDate.startMillis() == fromMillis) {
+            fromDate
+        } else {
+            fromDate.plus(1, DateTimeUnit.DAY)
+        }
+        val toDate = toMillis.toRollupDate()
+        val lastFullDate = if (toDate.plus(1, DateTimeUnit.DAY).startMillis() - 1 == toMillis) {
+            toDate
+        } else {
+            toDate.minus(1, DateTimeUnit.DAY)
+        }
+
+        if (firstFullDate > lastFullDate) {
+            return RollupSplit(head = fromMillis..toMillis, days = null, tail = null)
+        }
+
+        val daysStart = firstFullDate.startMillis()
+        val daysEnd = lastFullDate.plus(1, DateTimeUnit.DAY).startMillis() - 1
+        return RollupSplit(
+            head = if (fromMillis < daysStart) fromMillis until daysStart else null,
+            days = firstFullDate.toEpochDays().toLong()..lastFullDate.toEpochDays().toLong(),
+            tail = if (toMillis > daysEnd) (daysEnd + 1)..toMillis else null
+        )
+    }
+
+    private fun List<VisitEventEntity>.toDailyVisits(): List<ShopDailyVisitsEntity> {
+        val segments = rollupTimeZone.utcOffsetSegments(
+            minOf { it.timestampEpochMillis },
+            maxOf { it.timestampEpochMillis }
+        )
+        val counts = mutableMapOf<Pair<Long, Long>, Int>()
+        forEach { event ->
+            val millis = event.timestampEpochMillis
+            val day = segments.first { millis <= it.toEpochMillis }.epochDayOf(millis)
+            val key = event.shopKey to day
+            counts[key] = (counts[key] ?: 0) + 1
+        }
+        return counts.map { (key, count) -> ShopDailyVisitsEntity(key.first, key.second, count) }
+    }
+
+    // Records without a visitor hash are skipped.
+    private fun List<JournalRecord>.toDailyVisitors(): List<ShopDailyVisitorsEntity> {
+        if (isEmpty()) return emptyList()
+        val segments = rollupTimeZone.utcOffsetSegments(
+            minOf { it.epochMillis },
+            maxOf { it.epochMillis }
+        )
+        val sketches = mutableMapOf<Pair<Long, Long>, HyperLogLog>()
+        forEach { record ->
+            val visitorHash = record.visitorHash ?: return@forEach
+            val millis = record.epochMillis
+            val day = segments.first { millis <= it.toEpochMillis }.epochDayOf(millis)
+            sketches.getOrPut(record.shopKey to day) { HyperLogLog() }.addHash(visitorHash)
+        }
+        return sketches.map { (key, sketch) ->
+            ShopDailyVisitorsEntity(key.first, key.second, sketch.toByteArray())
+        }
+    }
+
+    private fun Long.toRollupDate(): LocalDate =
+        Instant.fromEpochMilliseconds(this).toLocalDateTime(rollupTimeZone).date
+
+    private fun Long.toRollupEpochDay(): Long = toRollupDate().toEpochDays().toLong()
+
+    private fun LocalDate.startMillis(): Long =
+        atStartOfDayIn(rollupTimeZone).toEpochMilliseconds()
+
+    // Raw millisecond ranges for the partial days at either end, and the whole rollup days between.
+    private class RollupSplit(
+        val head: LongRange?,
+        val days: LongRange?,
+        val tail: LongRange?
+    )
+
+    private companion object {
+        // Nothing has been purged yet.
+        const val NO_RAW_HORIZON = Long.MIN_VALUE
+    }
 }
+
+private fun VisitEvent.toEntity(shopKey: Long) = VisitEventEntity(
+    shopKey = shopKey,
+    timestampEpochMillis = timestamp.toEpochMilliseconds()
+)
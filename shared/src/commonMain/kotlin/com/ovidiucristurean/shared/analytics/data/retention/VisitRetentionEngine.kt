@@ -0,0 +1,128 @@
+package com.ovidiucristurean.shared.analytics.data.retention
+
+import androidx.room.Transactor
+import androidx.room.useWriterConnection
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsDatabase
+import com.ovidiucristurean.shared.analytics.data.repository.RoomAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.logMessage
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.yield
+import kotlinx.datetime.Clock
+import kotlinx.datetime.Instant
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.days
+
+/**
+ * Outcome of one [VisitRetentionEngine.run]. Raw visits before [rawHorizon] are gone.
+ */
+data class RetentionReport(
+    val rawHorizon: Instant,
+    val deletedVisits: Int,
+    val freedPages: Int
+)
+
+/**
+ * Keeps `analytics.db` from growing forever. Raw visits older than [rawWindow] are deleted in
+ * chunks of [chunkSize], each in its own short transaction, so tracker writes are never held up
+ * for long. Their counts stay in the `shop_daily_visits` rollup, so statistics reaching before
+ * the horizon are still answered, at day granularity. Each chunk is checked against the rollup
+ * first, and the purge stops at the first chunk whose days the rollup does not fully hold.
+ *
+ * The freed pages are then handed back to the file system by an incremental vacuum of at most
+ * [vacuumPages] pages. Databases opened with a storage profile are created in incremental
+ * auto-vacuum mode. Older files are not, and [run] leaves their free pages to be reused by new
+ * rows; [enableIncrementalVacuum] switches them over once.
+ *
+ * Call [run] from a background job, for example once a day.
+ */
+class VisitRetentionEngine(
+    private val database: AnalyticsDatabase,
+    private val repository: RoomAnalyticsRepository,
+    private val rawWindow: Duration = DEFAULT_RAW_WINDOW,
+    private val chunkSize: Int = DEFAULT_CHUNK_SIZE,
+    private val vacuumPages: Int = DEFAULT_VACUUM_PAGES,
+    private val clock: Clock = Clock.System
+) {
+    init {
+        require(rawWindow.isPositive()) { "rawWindow must be positive" }
+        require(chunkSize > 0) { "chunkSize must be positive" }
+        require(vacuumPages > 0) { "vacuumPages must be positive" }
+    }
+
+    suspend fun run(): RetentionReport {
+        val rawHorizon = repository.advanceRawHorizon(clock.now() - rawWindow)
+
+        var deletedVisits = 0
+        while (true) {
+            val deleted = try {
+                repository.deleteRawVisitsBefore(rawHorizon, chunkSize)
+            } catch (e: IllegalStateException) {
+                // Deleting these rows would lose visits, so they stay until the rollup is fixed.
+                logMessage("Stopped purging raw visits: ${e.message}")
+                break
+            }
+            deletedVisits += deleted
+            if (deleted < chunkSize) break
+            // The writer connection is free between chunks; let waiting writes go first.
+            yield()
+        }
+
+        return RetentionReport(
+            rawHorizon = Instant.fromEpochMilliseconds(rawHorizon),
+            deletedVisits = deletedVisits,
+            freedPages = reclaimSpace()
+        )
+    }
+
+    /**
+     * Switches a database created before incremental auto-vacuum over to it, with one full
+     * `VACUUM`. That rewrites the whole file while holding the write lock, so it is not part of
+     * [run]. Call it once, at a quiet moment such as right after an app update, not on every
+     * start. Returns false if the database was already in incremental mode.
+     */
+    suspend fun enableIncrementalVacuum(): Boolean = database.useWriterConnection { connection ->
+        if (connection.queryInt("PRAGMA auto_vacuum") == AUTO_VACUUM_INCREMENTAL) {
+            return@useWriterConnection false
+        }
+        // The new mode only takes effect with a full vacuum, which also frees every page.
+        connection.execute("PRAGMA auto_vacuum = INCREMENTAL")
+        connection.execute("VACUUM")
+        true
+    }
+
+    private suspend fun reclaimSpace(): Int = try {
+        database.useWriterConnection { connection ->
+            if (connection.queryInt("PRAGMA auto_vacuum") != AUTO_VACUUM_INCREMENTAL) {
+                // Only a full VACUUM could shrink this file; see enableIncrementalVacuum.
+                return@useWriterConnection 0
+            }
+            val freePages = connection.queryInt("PRAGMA freelist_count")
+            connection.execute("PRAGMA incremental_vacuum($vacuumPages)")
+            freePages - connection.queryInt("PRAGMA freelist_count")
+        }
+    } catch (e: CancellationException) {
+        throw e
+    } catch (e: Exception) {
+        // The pages stay on the free list and are reused by new rows or reclaimed next run.
+        logMessage("Failed to vacuum the analytics database: ${e.message}")
+        0
+    }
+
+    private suspend fun Transactor.queryInt(sql: String): Int = usePrepared(sql) { statement ->
+        if (statement.step()) statement.getLong(0).toInt() else 0
+    }
+
+    // Steps to the end, since some pragmas, incremental_vacuum among them, work row by row.
+    private suspend fun Transactor.execute(sql: String) {
+        usePrepared(sql) { statement ->
+            while (statement.step()) { }
+        }
+    }
+
+    companion object {
+        val DEFAULT_RAW_WINDOW = 90.days
+        const val DEFAULT_CHUNK_SIZE = 1000
+        const val DEFAULT_VACUUM_PAGES = 1024
+        private const val AUTO_VACUUM_INCREMENTAL = 2
+    }
+}
@@ -2,10 +2,25 @@ package com.ovidiucristurean.shared.analytics.domain.model
 
 import kotlinx.datetime.Instant
 import kotlinx.datetime.LocalDate
+import kotlin.time.Duration
 
+/**
+ * One visit to a shop. [visitorKey] is an opaque, stable id of the customer, such as a hashed
+ * loyalty card number. It is only used to estimate unique visitors and is never stored as is.
+ */
 data class VisitEvent(
     val shopId: String,
-    val timestamp: Instant
+    val timestamp: Instant,
+    val visitorKey: String? = null
+)
+
+/**
+ * Visits recorded after some watermark. Pass [watermark] to the next query to get only the visits
+ * recorded after these.
+ */
+data class RecordedVisits(
+    val visits: List<VisitEvent>,
+    val watermark: Long
 )
 
 data class ShopStatistics(
@@ -19,3 +34,55 @@ data class WeeklyTrend(
     val previousWeek: Int,
     val percentageChange: Double
 )
+
+enum class TrendPeriod {
+    DAY,
+    WEEK,
+    MONTH
+}
+
+/**
+ * Visits between [from] and [to], inclusive, compared with the equally long period before.
+ */
+data class PeriodVisits(
+    val from: Instant,
+    val to: Instant,
+    val visits: Int,
+    val previousVisits: Int,
+    val percentageChange: Double
+)
+
+/**
+ * Trailing periods of one [TrendPeriod] length, oldest first. The last one ends now.
+ */
+data class VisitTrend(
+    val period: TrendPeriod,
+    val periods: List<PeriodVisits>
+)
+
+/**
+ * Timestamps of one completed item tag, as in `ItemTag`. [customerReadAt] is null when the
+ * customer never read the tag.
+ */
+data class ItemTagLifecycle(
+    val shopId: String,
+    val createdAt: Instant,
+    val customerReadAt: Instant?,
+    val completedAt: Instant
+)
+
+data class ServiceTimeQuantiles(
+    val p50: Duration,
+    val p90: Duration,
+    val p99: Duration,
+    val sampleCount: Long
+)
+
+/**
+ * Service time quantiles of the item tags completed in a range. A quantile is null when no tag
+ * in the range has that duration.
+ */
+data class ServiceTimeStatistics(
+    val createdToCompleted: ServiceTimeQuantiles?,
+    val readToCompleted: ServiceTimeQuantiles?
+)
@@ -1,13 +1,138 @@
 package com.ovidiucristurean.shared.analytics.domain.repository
 
+import com.ovidiucristurean.shared.analytics.domain.model.ItemTagLifecycle
+import com.ovidiucristurean.shared.analytics.domain.model.RecordedVisits
+import com.ovidiucristurean.shared.analytics.domain.model.ServiceTimeStatistics
 import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlinx.coroutines.flow.Flow
 import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
 
 interface AnalyticsRepository {
     suspend fun recordVisit(event: VisitEvent)
+    suspend fun recordVisits(events: List<VisitEvent>)
     suspend fun getVisits(
         shopId: String,
         from: Instant,
         to: Instant
     ): List<VisitEvent>
+
+    /**
+     * Same visits as [getVisits], emitted in lists of at most [pageSize].
+     * Pages are loaded as they are collected, so memory use does not depend on the range. They
+     * are not guaranteed to be in time order.
+     */
+    fun getVisitsPaged(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        pageSize: Int = DEFAULT_PAGE_SIZE
+    ): Flow<List<VisitEvent>>
+
+    suspend fun countVisits(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Int
+
+    /**
+     * Visits in each period between consecutive [boundaries], which must be in ascending order.
+     * Element i counts the visits at or after `boundaries[i]` and before `boundaries[i + 1]`, so
+     * the result has one element fewer than [boundaries]. All periods are counted in one pass.
+     */
+    suspend fun countVisitsPerPeriod(
+        shopId: String,
+        boundaries: List<Instant>
+    ): IntArray
+
+    /**
+     * Visits per local day in [timeZone] between [from] and [to], inclusive. Days without visits
+     * are left out.
+     */
+    suspend fun getDailyVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<LocalDate, Int>
+
+    /**
+     * [getDailyVisitCounts] for several shops at once, keyed by shop id. Shops without visits in
+     * the range are left out.
+     */
+    suspend fun getDailyVisitCountsForShops(
+        shopIds: Collection<String>,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<String, Map<LocalDate, Int>>
+
+    /**
+     * Visits per local hour of the week in [timeZone] between [from] and [to], inclusive, in an
+     * array of 168 counts. Index 0 is Monday 00:00 to 00:59, index 167 is Sunday 23:00 to 23:59.
+     */
+    suspend fun getHourOfWeekVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): IntArray
+
+    /**
+     * Approximate number of distinct visitor keys among the visits of [shopId] between [from] and
+     * [to]. Visits without a visitor key are not counted. The estimate merges one sketch per shop
+     * and day, so [from] and [to] are rounded out to whole days, and it is typically within 2% of
+     * the exact count.
+     */
+    suspend fun countUniqueVisitors(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Long
+
+    /**
+     * Adds completed item tags to the service time sketches. Only sketches are kept, so record
+     * each tag once.
+     */
+    suspend fun recordItemTagLifecycles(lifecycles: List<ItemTagLifecycle>)
+
+    /**
+     * Approximate service time quantiles of the item tags of [shopId] completed between [from]
+     * and [to]. Like [countUniqueVisitors], it merges one sketch per shop and day, so [from] and
+     * [to] are rounded out to whole days.
+     */
+    suspend fun getServiceTimeStatistics(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): ServiceTimeStatistics
+
+    /**
+     * Emits once when collected and again after visits are recorded. Several writes may be
+     * reported as one emission.
+     */
+    fun observeVisitChanges(): Flow<Unit>
+
+    /**
+     * Marks everything recorded for [shopId] so far. Visits recorded later are returned by
+     * [getVisitsRecordedAfter].
+     */
+    suspend fun getWatermark(shopId: String): Long
+
+    /**
+     * Visits of [shopId] between [from] and [to] recorded after [watermark]. Returns null when
+     * the repository can no longer tell which visits those are. Callers then recompute from
+     * scratch.
+     */
+    suspend fun getVisitsRecordedAfter(
+        shopId: String,
+        watermark: Long,
+        from: Instant,
+        to: Instant
+    ): RecordedVisits?
+
+    companion object {
+        const val DEFAULT_PAGE_SIZE = 500
+    }
 }
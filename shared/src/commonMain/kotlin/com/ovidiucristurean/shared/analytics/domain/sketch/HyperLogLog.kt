@@ -0,0 +1,80 @@
+package com.ovidiucristurean.shared.analytics.domain.sketch
+
+import kotlin.math.ln
+import kotlin.math.roundToLong
+
+/**
+ * HyperLogLog sketch of a set of visitor keys: estimates how many distinct keys were added, with
+ * a standard error of about 1.6%, in a fixed [SIZE_BYTES] however many keys there are. Sketches
+ * merge losslessly, so the sketch of a date range is the merge of its daily sketches, and adding
+ * the same key twice changes nothing.
+ *
+ * Only a 64-bit hash of each key ends up in the registers; the keys themselves are not kept.
+ */
+internal class HyperLogLog private constructor(private val registers: ByteArray) {
+    constructor() : this(ByteArray(REGISTER_COUNT))
+
+    fun add(visitorKey: String) {
+        addHash(hashOf(visitorKey))
+    }
+
+    // For keys hashed earlier with [hashOf], such as those in the visit journal.
+    fun addHash(hash: Long) {
+        val index = (hash ushr (64 - PRECISION)).toInt()
+        // The sentinel bit caps the rank at 64 - PRECISION + 1 once the index bits are shifted out.
+        val rank = ((hash shl PRECISION) or (1L shl (PRECISION - 1))).countLeadingZeroBits() + 1
+        if (rank > registers[index]) registers[index] = rank.toByte()
+    }
+
+    fun merge(other: HyperLogLog) {
+        for (index in registers.indices) {
+            if (other.registers[index] > registers[index]) registers[index] = other.registers[index]
+        }
+    }
+
+    fun estimate(): Long {
+        var sum = 0.0
+        var emptyRegisters = 0
+        for (register in registers) {
+            sum += 1.0 / (1L shl register.toInt())
+            if (register.toInt() == 0) emptyRegisters++
+        }
+        val m = REGISTER_COUNT.toDouble()
+        val estimate = ALPHA * m * m / sum
+        // Linear counting is more accurate while many registers are still empty.
+        return if (estimate <= 2.5 * m && emptyRegisters > 0) {
+            (m * ln(m / emptyRegisters)).roundToLong()
+        } else {
+            estimate.roundToLong()
+        }
+    }
+
+    fun toByteArray(): ByteArray = registers.copyOf()
+
+    companion object {
+        private const val PRECISION = 12
+        private const val REGISTER_COUNT = 1 shl PRECISION
+        const val SIZE_BYTES = REGISTER_COUNT
+        private const val ALPHA = 0.7213 / (1 + 1.079 / REGISTER_COUNT)
+
+        private const val FNV_OFFSET_BASIS = -0x340d631b7bdddcdbL
+        private const val FNV_PRIME = 0x100000001b3L
+
+        fun fromByteArray(bytes: ByteArray): HyperLogLog {
+            require(bytes.size == REGISTER_COUNT) { "Not a visitor sketch: ${bytes.size} bytes" }
+            return HyperLogLog(bytes.copyOf())
+        }
+
+        // FNV-1a over the UTF-8 bytes, then MurmurHash3's finalizer, since the register index
+        // comes from the high bits, which FNV-1a alone mixes poorly.
+        fun hashOf(visitorKey: String): Long {
+            var hash = FNV_OFFSET_BASIS
+            for (byte in visitorKey.encodeToByteArray()) {
+                hash = (hash xor (byte.toLong() and 0xff)) * FNV_PRIME
+            }
+            hash = (hash xor (hash ushr 33)) * -0xae502812aa7333L
+            hash = (hash xor (hash ushr 33)) * -0x3b314601e57a13adL
+            return hash xor (hash ushr 33)
+        }
+    }
+}
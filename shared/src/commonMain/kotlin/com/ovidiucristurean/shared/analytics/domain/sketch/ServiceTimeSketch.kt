@@ -0,0 +1,46 @@
+package com.ovidiucristurean.shared.analytics.domain.sketch
+
+import com.ovidiucristurean.shared.analytics.domain.model.ItemTagLifecycle
+import com.ovidiucristurean.shared.analytics.domain.model.ServiceTimeQuantiles
+import com.ovidiucristurean.shared.analytics.domain.model.ServiceTimeStatistics
+import kotlin.time.Duration.Companion.milliseconds
+
+/**
+ * The two service time digests of a set of item tags: created to completed, and read to
+ * completed, in milliseconds.
+ */
+internal class ServiceTimeSketch(
+    val createdToCompleted: TDigest = TDigest(),
+    val readToCompleted: TDigest = TDigest()
+) {
+    fun add(lifecycle: ItemTagLifecycle) {
+        val completedMillis = lifecycle.completedAt.toEpochMilliseconds()
+        // Clock skew between devices can put completion before creation; such tags say nothing.
+        val sinceCreated = completedMillis - lifecycle.createdAt.toEpochMilliseconds()
+        if (sinceCreated >= 0) createdToCompleted.add(sinceCreated.toDouble())
+        val readAt = lifecycle.customerReadAt ?: return
+        val sinceRead = completedMillis - readAt.toEpochMilliseconds()
+        if (sinceRead >= 0) readToCompleted.add(sinceRead.toDouble())
+    }
+
+    fun merge(other: ServiceTimeSketch) {
+        createdToCompleted.merge(other.createdToCompleted)
+        readToCompleted.merge(other.readToCompleted)
+    }
+
+    fun toStatistics() = ServiceTimeStatistics(
+        createdToCompleted = createdToCompleted.toQuantiles(),
+        readToCompleted = readToCompleted.toQuantiles()
+    )
+
+    private fun TDigest.toQuantiles(): ServiceTimeQuantiles? {
+        val count = count
+        if (count == 0L) return null
+        return ServiceTimeQuantiles(
+            p50 = quantile(0.5).milliseconds,
+            p90 = quantile(0.9).milliseconds,
+            p99 = quantile(0.99).milliseconds,
+            sampleCount = count
+        )
+    }
+}
@@ -0,0 +1,163 @@
+package com.ovidiucristurean.shared.analytics.domain.sketch
+
+import okio.Buffer
+import kotlin.math.PI
+import kotlin.math.asin
+import kotlin.math.sin
+
+/**
+ * Merging t-digest: estimates quantiles of a stream of values from a few hundred weighted
+ * centroids, however many values were added. Digests merge, so the digest of a date range is the
+ * merge of its daily digests. Centroids are kept small near both tails, so p99 stays accurate.
+ *
+ * Serialized, a digest takes at most about [COMPRESSION] * 16 bytes.
+ */
+internal class TDigest {
+    private var means = DoubleArray(0)
+    private var weights = DoubleArray(0)
+    private val buffer = DoubleArray(BUFFER_SIZE)
+    private var buffered = 0
+    private var min = Double.POSITIVE_INFINITY
+    private var max = Double.NEGATIVE_INFINITY
+
+    val count: Long
+        get() = (weights.sum() + buffered).toLong()
+
+    fun add(value: Double) {
+        require(!value.isNaN()) { "Cannot add NaN" }
+        if (buffered == BUFFER_SIZE) compress()
+        buffer[buffered++] = value
+        if (value < min) min = value
+        if (value > max) max = value
+    }
+
+    fun merge(other: TDigest) {
+        other.compress()
+        if (other.means.isEmpty()) return
+        if (other.min < min) min = other.min
+        if (other.max > max) max = other.max
+        compress(other.means, other.weights)
+    }
+
+    /**
+     * The value below which a fraction [q] of the added values lie, or NaN when nothing was added.
+     */
+    fun quantile(q: Double): Double {
+        require(q in 0.0..1.0) { "q must be between 0 and 1" }
+        compress()
+        val count = means.size
+        if (count == 0) return Double.NaN
+        if (count == 1) return min + q * (max - min)
+
+        // Each centroid's mean sits at the middle of its weight; interpolate between neighbours,
+        // and between min or max and the outermost centroids.
+        val target = q * weights.sum()
+        val firstHalf = weights[0] / 2
+        if (target < firstHalf) return min + (means[0] - min) * target / firstHalf
+        var weightSoFar = firstHalf
+        for (index in 0 until count - 1) {
+            val step = (weights[index] + weights[index + 1]) / 2
+            if (weightSoFar + step > target) {
+                val fraction = (target - weightSoFar) / step
+                return means[index] + fraction * (means[index + 1] - means[index])
+            }
+            weightSoFar += step
+        }
+        val lastHalf = weights[count - 1] / 2
+        val fraction = ((target - weightSoFar) / lastHalf).coerceAtMost(1.0)
+        return means[count - 1] + (max - means[count - 1]) * fraction
+    }
+
+    fun toByteArray(): ByteArray {
+        compress()
+        val bytes = Buffer()
+            .writeInt(means.size)
+            .writeLong(min.toRawBits())
+            .writeLong(max.toRawBits())
+        for (index in means.indices) {
+            bytes.writeLong(means[index].toRawBits()).writeLong(weights[index].toRawBits())
+        }
+        return bytes.readByteArray()
+    }
+
+    // Merges the buffered values, and any centroids of another digest, into the centroids.
+    private fun compress(
+        otherMeans: DoubleArray = EMPTY,
+        otherWeights: DoubleArray = EMPTY
+    ) {
+        if (buffered == 0 && otherMeans.isEmpty()) return
+
+        val size = means.size + buffered + otherMeans.size
+        val allMeans = DoubleArray(size)
+        val allWeights = DoubleArray(size)
+        means.copyInto(allMeans)
+        weights.copyInto(allWeights)
+        for (index in 0 until buffered) {
+            allMeans[means.size + index] = buffer[index]
+            allWeights[means.size + index] = 1.0
+        }
+        otherMeans.copyInto(allMeans, means.size + buffered)
+        otherWeights.copyInto(allWeights, means.size + buffered)
+        buffered = 0
+
+        val order = (0 until size).sortedBy { allMeans[it] }
+        val totalWeight = allWeights.sum()
+        val newMeans = DoubleArray(size)
+        val newWeights = DoubleArray(size)
+        var newCount = 0
+        var weightSoFar = 0.0
+        var limit = totalWeight * nextQuantileLimit(0.0)
+        var mean = allMeans[order[0]]
+        var weight = allWeights[order[0]]
+        for (position in 1 until size) {
+            val index = order[position]
+            if (weightSoFar + weight + allWeights[index] <= limit) {
+                weight += allWeights[index]
+                mean += (allMeans[index] - mean) * allWeights[index] / weight
+            } else {
+                newMeans[newCount] = mean
+                newWeights[newCount] = weight
+                newCount++
+                weightSoFar += weight
+                limit = totalWeight * nextQuantileLimit(weightSoFar / totalWeight)
+                mean = allMeans[index]
+                weight = allWeights[index]
+            }
+        }
+        newMeans[newCount] = mean
+        newWeights[newCount] = weight
+        newCount++
+
+        means = newMeans.copyOf(newCount)
+        weights = newWeights.copyOf(newCount)
+    }
+
+    // The k1 scale function allows one unit of k per centroid. It changes fastest near q = 0 and
+    // q = 1, which is what keeps the tail centroids small.
+    private fun nextQuantileLimit(q: Double): Double {
+        val k = COMPRESSION / (2 * PI) * asin(2 * q - 1) + 1
+        if (k >= COMPRESSION / 4) return 1.0
+        return (sin(k * 2 * PI / COMPRESSION) + 1) / 2
+    }
+
+    companion object {
+        private const val COMPRESSION = 200.0
+        private const val BUFFER_SIZE = 256
+        private val EMPTY = DoubleArray(0)
+
+        fun fromByteArray(bytes: ByteArray): TDigest {
+            val source = Buffer().write(bytes)
+            val count = source.readInt()
+            return TDigest().apply {
+                min = Double.fromBits(source.readLong())
+                max = Double.fromBits(source.readLong())
+                means = DoubleArray(count)
+                weights = DoubleArray(count)
+                for (index in 0 until count) {
+                    means[index] = Double.fromBits(source.readLong())
+                    weights[index] = Double.fromBits(source.readLong())
+                }
+            }
+        }
+    }
+}
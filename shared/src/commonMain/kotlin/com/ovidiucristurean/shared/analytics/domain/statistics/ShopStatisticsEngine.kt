@@ -0,0 +1,138 @@
+package com.ovidiucristurean.shared.analytics.domain.statistics
+
+import com.ovidiucristurean.shared.analytics.domain.model.ShopStatistics
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.usecase.shopStatisticsOf
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
+import kotlinx.datetime.toLocalDateTime
+import kotlin.time.Duration.Companion.days
+import kotlin.time.Duration.Companion.milliseconds
+
+/**
+ * Computes [ShopStatistics] and remembers the daily counts and repository watermark behind the
+ * last result for each shop. The next call folds in only visits recorded after the watermark.
+ * If the window moved by at most a day, only the slivers that entered or left it are queried.
+ * Anything else is recomputed from scratch.
+ *
+ * A visit recorded while a range is being counted could be counted again when a later call
+ * folds in the visits after the watermark. Every range query is therefore bracketed by two
+ * watermark reads. If the watermark moved, the result is not trusted: an incremental update
+ * falls back to a recompute, and a recompute is retried. A window that keeps racing writers is
+ * still returned, like any plain recount would be, but it is not cached.
+ */
+class ShopStatisticsEngine(
+    private val repository: AnalyticsRepository,
+    private val maxCachedShops: Int = DEFAULT_MAX_CACHED_SHOPS
+) {
+    private val mutex = Mutex()
+    private val windows = LinkedHashMap<String, Window>()
+
+    suspend fun statistics(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): ShopStatistics = mutex.withLock {
+        val cached = windows.remove(shopId)
+        val window = cached?.takeIf { it.canMoveTo(from, to, timeZone) }
+            ?.let { update(shopId, it, from, to) }
+            ?: recompute(shopId, from, to, timeZone)
+
+        if (window.isExact) {
+            // Re-inserting keeps the map in least-recently-used order.
+            windows[shopId] = window
+            if (windows.size > maxCachedShops) windows.remove(windows.keys.first())
+        }
+        shopStatisticsOf(window.visitsPerDay, from, to, timeZone)
+    }
+
+    private suspend fun update(
+        shopId: String,
+        window: Window,
+        from: Instant,
+        to: Instant
+    ): Window? {
+        val recorded = repository.getVisitsRecordedAfter(
+            shopId,
+            window.watermark,
+            window.from,
+            window.to
+        ) ?: return null
+        recorded.visits.forEach { visit ->
+            window.add(visit.timestamp.toLocalDateTime(window.timeZone).date, 1)
+        }
+        window.watermark = recorded.watermark
+
+        if (from < window.from) addRange(shopId, window, from, window.from - 1.milliseconds, 1)
+        if (from > window.from) addRange(shopId, window, window.from, from - 1.milliseconds, -1)
+        if (to > window.to) addRange(shopId, window, window.to + 1.milliseconds, to, 1)
+        if (to < window.to) addRange(shopId, window, to + 1.milliseconds, window.to, -1)
+        val movedWindow = from != window.from || to != window.to
+        if (movedWindow && repository.getWatermark(shopId) != recorded.watermark) return null
+        window.from = from
+        window.to = to
+        return window
+    }
+
+    private suspend fun addRange(
+        shopId: String,
+        window: Window,
+        from: Instant,
+        to: Instant,
+        sign: Int
+    ) {
+        repository.getDailyVisitCounts(shopId, from, to, window.timeZone).forEach { (date, count) ->
+            window.add(date, sign * count)
+        }
+    }
+
+    // The watermark is read first, so visits recorded during the query would be folded in again
+    // on the next call. Reading it again afterwards tells whether that can have happened.
+    private suspend fun recompute(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Window {
+        var attempt = 1
+        while (true) {
+            val watermark = repository.getWatermark(shopId)
+            val visitsPerDay = repository.getDailyVisitCounts(shopId, from, to, timeZone)
+            val isExact = repository.getWatermark(shopId) == watermark
+            if (isExact || attempt++ == MAX_RECOMPUTE_ATTEMPTS) {
+                return Window(from, to, timeZone, visitsPerDay.toMutableMap(), watermark, isExact)
+            }
+        }
+    }
+
+    private class Window(
+        var from: Instant,
+        var to: Instant,
+        val timeZone: TimeZone,
+        val visitsPerDay: MutableMap<LocalDate, Int>,
+        var watermark: Long,
+        // False if visits were recorded while counting, so the watermark may not match the counts.
+        val isExact: Boolean = true
+    ) {
+        fun canMoveTo(newFrom: Instant, newTo: Instant, newTimeZone: TimeZone): Boolean =
+            newTimeZone.id == timeZone.id &&
+                newFrom <= newTo &&
+                (newFrom - from).absoluteValue <= MAX_WINDOW_SHIFT &&
+                (newTo - to).absoluteValue <= MAX_WINDOW_SHIFT
+
+        fun add(date: LocalDate, delta: Int) {
+            val count = (visitsPerDay[date] ?: 0) + delta
+            if (count == 0) visitsPerDay.remove(date) else visitsPerDay[date] = count
+        }
+    }
+
+    companion object {
+        const val DEFAULT_MAX_CACHED_SHOPS = 16
+        private const val MAX_RECOMPUTE_ATTEMPTS = 3
+        private val MAX_WINDOW_SHIFT = 1.days
+    }
+}
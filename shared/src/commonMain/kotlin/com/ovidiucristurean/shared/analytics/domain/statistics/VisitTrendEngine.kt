@@ -0,0 +1,64 @@
+package com.ovidiucristurean.shared.analytics.domain.statistics
+
+import com.ovidiucristurean.shared.analytics.domain.model.PeriodVisits
+import com.ovidiucristurean.shared.analytics.domain.model.TrendPeriod
+import com.ovidiucristurean.shared.analytics.domain.model.VisitTrend
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import kotlinx.datetime.DateTimeUnit
+import kotlinx.datetime.Instant
+import kotlinx.datetime.TimeZone
+import kotlinx.datetime.minus
+import kotlin.time.Duration.Companion.milliseconds
+
+/**
+ * Compares the visits of trailing days, weeks or months. All periods, plus the one before the
+ * oldest, are counted by a single [AnalyticsRepository.countVisitsPerPeriod] call.
+ *
+ * Periods are calendar periods in the given time zone, so a day across a DST change is 23 or 25
+ * hours and a month is as long as the month it ends in.
+ */
+class VisitTrendEngine(private val repository: AnalyticsRepository) {
+    suspend fun trend(
+        shopId: String,
+        now: Instant,
+        period: TrendPeriod,
+        periodCount: Int,
+        timeZone: TimeZone
+    ): VisitTrend {
+        require(periodCount in 1..MAX_PERIOD_COUNT) {
+            "periodCount must be between 1 and $MAX_PERIOD_COUNT"
+        }
+        // The last period includes now. Every boundary is measured from the same end, so months
+        // do not drift when a short month comes before a long one.
+        val end = now + 1.milliseconds
+        val unit = period.toDateTimeUnit()
+        val boundaries = (periodCount + 1 downTo 0).map { end.minus(it, unit, timeZone) }
+        val counts = repository.countVisitsPerPeriod(shopId, boundaries)
+
+        val periods = (1..periodCount).map { index ->
+            PeriodVisits(
+                from = boundaries[index],
+                to = boundaries[index + 1] - 1.milliseconds,
+                visits = counts[index],
+                previousVisits = counts[index - 1],
+                percentageChange = percentageChange(counts[index - 1], counts[index])
+            )
+        }
+        return VisitTrend(period, periods)
+    }
+
+    private fun TrendPeriod.toDateTimeUnit(): DateTimeUnit = when (this) {
+        TrendPeriod.DAY -> DateTimeUnit.DAY
+        TrendPeriod.WEEK -> DateTimeUnit.WEEK
+        TrendPeriod.MONTH -> DateTimeUnit.MONTH
+    }
+
+    private fun percentageChange(previous: Int, current: Int): Double = when {
+        previous == 0 -> if (current == 0) 0.0 else 100.0
+        else -> ((current - previous).toDouble() / previous) * 100.0
+    }
+
+    companion object {
+        const val MAX_PERIOD_COUNT = 12
+    }
+}
@@ -0,0 +1,33 @@
+package com.ovidiucristurean.shared.analytics.domain.time
+
+import kotlinx.datetime.LocalDate
+
+/**
+ * Per-day visit counters for the local days covered by [segments], backed by a single [IntArray]
+ * so that bucketing a visit does not allocate.
+ */
+internal class DailyVisitBuckets(private val segments: List<UtcOffsetSegment>) {
+    private val firstEpochDay = segments.firstOrNull()
+        ?.let { it.epochDayOf(it.fromEpochMillis) } ?: 0L
+    private val counts = IntArray(
+        segments.lastOrNull()
+            ?.let { (it.epochDayOf(it.toEpochMillis) - firstEpochDay + 1).toInt() } ?: 0
+    )
+
+    val epochDays: LongRange = firstEpochDay until firstEpochDay + counts.size
+
+    fun addVisit(epochMillis: Long) {
+        val segment = segments.first { epochMillis <= it.toEpochMillis }
+        counts[(segment.epochDayOf(epochMillis) - firstEpochDay).toInt()]++
+    }
+
+    fun addVisits(epochDay: Long, count: Int) {
+        counts[(epochDay - firstEpochDay).toInt()] += count
+    }
+
+    fun nonZeroDays(): Map<LocalDate, Int> = buildMap {
+        counts.forEachIndexed { index, count ->
+            if (count > 0) put(LocalDate.fromEpochDays((firstEpochDay + index).toInt()), count)
+        }
+    }
+}
@@ -0,0 +1,20 @@
+package com.ovidiucristurean.shared.analytics.domain.time
+
+/**
+ * Visit counters per local hour of the week for the stretch of time covered by [segments],
+ * indexed as in [UtcOffsetSegment.hourOfWeekOf]. Bucketing a visit does not allocate.
+ */
+internal class HourOfWeekBuckets(private val segments: List<UtcOffsetSegment>) {
+    private val counts = IntArray(HOURS_PER_WEEK)
+
+    fun addVisit(epochMillis: Long) {
+        val segment = segments.first { epochMillis <= it.toEpochMillis }
+        counts[segment.hourOfWeekOf(epochMillis)]++
+    }
+
+    fun addVisits(hourOfWeek: Int, count: Int) {
+        counts[hourOfWeek] += count
+    }
+
+    fun toIntArray(): IntArray = counts.copyOf()
+}
@@ -0,0 +1,84 @@
+package com.ovidiucristurean.shared.analytics.domain.time
+
+import kotlinx.datetime.FixedOffsetTimeZone
+import kotlinx.datetime.Instant
+import kotlinx.datetime.TimeZone
+import kotlinx.datetime.offsetAt
+
+internal const val MILLIS_PER_DAY = 86_400_000L
+internal const val MILLIS_PER_HOUR = 3_600_000L
+internal const val HOURS_PER_WEEK = 7 * 24
+
+// Offset transitions are months apart, so probing twice a day cannot step over one.
+private const val PROBE_STEP_MILLIS = MILLIS_PER_DAY / 2
+
+/**
+ * A stretch of time, inclusive on both ends, during which a time zone keeps the same UTC offset.
+ * Within a segment the local day of an instant is plain integer arithmetic.
+ */
+internal data class UtcOffsetSegment(
+    val fromEpochMillis: Long,
+    val toEpochMillis: Long,
+    val offsetMillis: Long
+) {
+    fun epochDayOf(epochMillis: Long): Long = (epochMillis + offsetMillis).floorDiv(MILLIS_PER_DAY)
+
+    /**
+     * Local hour of the week of [epochMillis], from 0 for Monday 00:00 to 167 for Sunday 23:00.
+     */
+    fun hourOfWeekOf(epochMillis: Long): Int {
+        val localMillis = epochMillis + offsetMillis
+        // Epoch day 0 was a Thursday, three days after a Monday.
+        val dayOfWeek = (localMillis.floorDiv(MILLIS_PER_DAY) + 3).mod(7)
+        val hourOfDay = localMillis.mod(MILLIS_PER_DAY) / MILLIS_PER_HOUR
+        return (dayOfWeek * 24 + hourOfDay).toInt()
+    }
+}
+
+/**
+ * Splits `[fromEpochMillis, toEpochMillis]` at every UTC offset change of this zone, such as DST
+ * transitions. A range without transitions comes back as a single segment.
+ */
+internal fun TimeZone.utcOffsetSegments(
+    fromEpochMillis: Long,
+    toEpochMillis: Long
+): List<UtcOffsetSegment> {
+    if (fromEpochMillis > toEpochMillis) return emptyList()
+    if (this is FixedOffsetTimeZone) {
+        return listOf(UtcOffsetSegment(fromEpochMillis, toEpochMillis, offsetMillisAt(fromEpochMillis)))
+    }
+
+    val segments = mutableListOf<UtcOffsetSegment>()
+    var segmentStart = fromEpochMillis
+    var segmentOffset = offsetMillisAt(fromEpochMillis)
+    var probe = fromEpochMillis
+    while (probe < toEpochMillis) {
+        val next = minOf(probe + PROBE_STEP_MILLIS, toEpochMillis)
+        if (offsetMillisAt(next) != segmentOffset) {
+            val transition = firstMillisWithNewOffset(probe, next, segmentOffset)
+            segments += UtcOffsetSegment(segmentStart, transition - 1, segmentOffset)
+            segmentStart = transition
+            segmentOffset = offsetMillisAt(transition)
+        }
+        probe = next
+    }
+    segments += UtcOffsetSegment(segmentStart, toEpochMillis, segmentOffset)
+    return segments
+}
+
+private fun TimeZone.firstMillisWithNewOffset(
+    sameOffsetMillis: Long,
+    newOffsetMillis: Long,
+    offset: Long
+): Long {
+    var low = sameOffsetMillis
+    var high = newOffsetMillis
+    while (high - low > 1) {
+        val mid = low + (high - low) / 2
+        if (offsetMillisAt(mid) == offset) low = mid else high = mid
+    }
+    return high
+}
+
+private fun TimeZone.offsetMillisAt(epochMillis: Long): Long =
+    offsetAt(Instant.fromEpochMilliseconds(epochMillis)).totalSeconds * 1000L
@@ -0,0 +1,18 @@
+package com.ovidiucristurean.shared.analytics.domain.usecase
+
+import com.ovidiucristurean.shared.analytics.domain.model.ServiceTimeStatistics
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import kotlinx.datetime.Instant
+
+/**
+ * p50, p90 and p99 of how long item tags at a shop waited to be completed, from creation and from
+ * when the customer read them. See [AnalyticsRepository.getServiceTimeStatistics] for the day
+ * rounding.
+ */
+class GetServiceTimeQuantilesUseCase(private val repository: AnalyticsRepository) {
+    suspend operator fun invoke(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): ServiceTimeStatistics = repository.getServiceTimeStatistics(shopId, from, to)
+}
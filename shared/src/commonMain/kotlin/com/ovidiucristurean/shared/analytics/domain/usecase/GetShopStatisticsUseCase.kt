@@ -2,6 +2,7 @@ package com.ovidiucristurean.shared.analytics.domain.usecase
 
 import com.ovidiucristurean.shared.analytics.domain.model.ShopStatistics
 import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.statistics.ShopStatisticsEngine
 import kotlinx.datetime.DateTimeUnit
 import kotlinx.datetime.Instant
 import kotlinx.datetime.LocalDate
@@ -9,42 +10,55 @@ import kotlinx.datetime.TimeZone
 import kotlinx.datetime.plus
 import kotlinx.datetime.toLocalDateTime
 
-class GetShopStatisticsUseCase(private val repository: AnalyticsRepository) {
+/**
+ * Statistics for one shop over a range. The instance remembers the windows it computed, so
+ * asking again only reads the visits recorded since. Give each consumer its own instance and keep
+ * it for as long as that consumer refreshes: a fresh instance per call recomputes every time.
+ */
+class GetShopStatisticsUseCase(repository: AnalyticsRepository) {
+  private val engine = ShopStatisticsEngine(repository)
+
   suspend operator fun invoke(
     shopId: String,
     from: Instant,
     to: Instant,
     timeZone: TimeZone = TimeZone.UTC
   ): ShopStatistics {
-    val visits = repository.getVisits(shopId, from, to)
-    val totalVisits = visits.size
-
-    val startDate = from.toLocalDateTime(timeZone).date
-    val endDate = to.toLocalDateTime(timeZone).date
-
-    val dailyBreakdown = mutableMapOf<LocalDate, Int>()
-    var current = startDate
-    while (current <= endDate) {
-      dailyBreakdown[current] = 0
-      current = current.plus(1, DateTimeUnit.DAY)
-    }
-
-    visits.forEach { visit ->
-      val date = visit.timestamp.toLocalDateTime(timeZone).date
-      dailyBreakdown[date] = (dailyBreakdown[date] ?: 0) + 1
-    }
-
-    val numberOfDays = dailyBreakdown.size
-    val averagePerDay = if (numberOfDays > 0) {
-      totalVisits.toDouble() / numberOfDays
-    } else {
-      0.0
-    }
-
-    return ShopStatistics(
-      totalVisits = totalVisits,
-      averagePerDay = averagePerDay,
-      dailyBreakdown = dailyBreakdown
-    )
+    return engine.statistics(shopId, from, to, timeZone)
   }
 }
+
+/**
+ * Builds [ShopStatistics] from non-zero daily counts, filling in the days without visits.
+ */
+internal fun shopStatisticsOf(
+  visitsPerDay: Map<LocalDate, Int>,
+  from: Instant,
+  to: Instant,
+  timeZone: TimeZone
+): ShopStatistics {
+  val totalVisits = visitsPerDay.values.sum()
+
+  val startDate = from.toLocalDateTime(timeZone).date
+  val endDate = to.toLocalDateTime(timeZone).date
+
+  val dailyBreakdown = mutableMapOf<LocalDate, Int>()
+  var current = startDate
+  while (current <= endDate) {
+    dailyBreakdown[current] = visitsPerDay[current] ?: 0
+    current = current.plus(1, DateTimeUnit.DAY)
+  }
+
+  val numberOfDays = dailyBreakdown.size
+  val averagePerDay = if (numberOfDays > 0) {
+    totalVisits.toDouble() / numberOfDays
+  } else {
+    0.0
+  }
+
+  return ShopStatistics(
+    totalVisits = totalVisits,
+    averagePerDay = averagePerDay,
+    dailyBreakdown = dailyBreakdown
+  )
+}
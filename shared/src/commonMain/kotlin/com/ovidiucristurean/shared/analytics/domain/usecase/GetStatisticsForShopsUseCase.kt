@@ -0,0 +1,24 @@
+package com.ovidiucristurean.shared.analytics.domain.usecase
+
+import com.ovidiucristurean.shared.analytics.domain.model.ShopStatistics
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import kotlinx.datetime.Instant
+import kotlinx.datetime.TimeZone
+
+/**
+ * [GetShopStatisticsUseCase] for a whole set of shops, backed by a single repository query so
+ * the cost does not grow with the number of shops.
+ */
+class GetStatisticsForShopsUseCase(private val repository: AnalyticsRepository) {
+    suspend operator fun invoke(
+        shopIds: Collection<String>,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone = TimeZone.UTC
+    ): Map<String, ShopStatistics> {
+        val visitsPerDayByShop = repository.getDailyVisitCountsForShops(shopIds, from, to, timeZone)
+        return shopIds.associateWith { shopId ->
+            shopStatisticsOf(visitsPerDayByShop[shopId].orEmpty(), from, to, timeZone)
+        }
+    }
+}
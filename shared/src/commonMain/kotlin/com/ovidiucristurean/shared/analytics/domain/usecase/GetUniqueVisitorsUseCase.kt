@@ -0,0 +1,16 @@
+package com.ovidiucristurean.shared.analytics.domain.usecase
+
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import kotlinx.datetime.Instant
+
+/**
+ * Estimated number of distinct customers who visited a shop, counted from the visitor keys passed
+ * to the tracker. See [AnalyticsRepository.countUniqueVisitors] for the accuracy and day rounding.
+ */
+class GetUniqueVisitorsUseCase(private val repository: AnalyticsRepository) {
+    suspend operator fun invoke(
+        shopId: String,
+        from: Instant,
+        to: Instant
+    ): Long = repository.countUniqueVisitors(shopId, from, to)
+}
@@ -0,0 +1,19 @@
+package com.ovidiucristurean.shared.analytics.domain.usecase
+
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import kotlinx.datetime.Instant
+import kotlinx.datetime.TimeZone
+
+/**
+ * Visit counts per local hour of the week, for staffing. The result has 168 entries: index
+ * `dayOfWeek * 24 + hour`, with Monday as day 0, so index 0 is Monday 00:00 and index 167 is
+ * Sunday 23:00. Visits are bucketed by the repository in a single pass.
+ */
+class GetVisitHeatmapUseCase(private val repository: AnalyticsRepository) {
+    suspend operator fun invoke(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone = TimeZone.UTC
+    ): IntArray = repository.getHourOfWeekVisitCounts(shopId, from, to, timeZone)
+}
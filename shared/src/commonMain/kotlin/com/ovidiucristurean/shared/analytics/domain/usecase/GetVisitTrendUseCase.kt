@@ -0,0 +1,24 @@
+package com.ovidiucristurean.shared.analytics.domain.usecase
+
+import com.ovidiucristurean.shared.analytics.domain.model.TrendPeriod
+import com.ovidiucristurean.shared.analytics.domain.model.VisitTrend
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.statistics.VisitTrendEngine
+import kotlinx.datetime.Instant
+import kotlinx.datetime.TimeZone
+
+/**
+ * Day-over-day, week-over-week or month-over-month visits for up to
+ * [VisitTrendEngine.MAX_PERIOD_COUNT] trailing periods ending at [now].
+ */
+class GetVisitTrendUseCase(repository: AnalyticsRepository) {
+    private val engine = VisitTrendEngine(repository)
+
+    suspend operator fun invoke(
+        shopId: String,
+        now: Instant,
+        period: TrendPeriod,
+        periodCount: Int,
+        timeZone: TimeZone = TimeZone.UTC
+    ): VisitTrend = engine.trend(shopId, now, period, periodCount, timeZone)
+}
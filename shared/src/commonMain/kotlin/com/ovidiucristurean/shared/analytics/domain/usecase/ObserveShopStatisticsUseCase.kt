@@ -0,0 +1,44 @@
+package com.ovidiucristurean.shared.analytics.domain.usecase
+
+import com.ovidiucristurean.shared.analytics.domain.model.ShopStatistics
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.statistics.ShopStatisticsEngine
+import kotlinx.coroutines.FlowPreview
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.debounce
+import kotlinx.coroutines.flow.distinctUntilChanged
+import kotlinx.coroutines.flow.emitAll
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.map
+import kotlinx.datetime.Instant
+import kotlinx.datetime.TimeZone
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.milliseconds
+
+/**
+ * Emits [ShopStatistics] for a shop and re-emits whenever its visits change, so dashboards do not
+ * have to poll. Each collector gets its own [ShopStatisticsEngine], so after the first emission
+ * only visits recorded since the previous one are folded in.
+ */
+class ObserveShopStatisticsUseCase(private val repository: AnalyticsRepository) {
+    @OptIn(FlowPreview::class)
+    operator fun invoke(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone = TimeZone.UTC,
+        debounce: Duration = DEFAULT_DEBOUNCE
+    ): Flow<ShopStatistics> = flow {
+        val engine = ShopStatisticsEngine(repository, maxCachedShops = 1)
+        emitAll(
+            repository.observeVisitChanges()
+                .debounce(debounce)
+                .map { engine.statistics(shopId, from, to, timeZone) }
+                .distinctUntilChanged()
+        )
+    }
+
+    companion object {
+        val DEFAULT_DEBOUNCE = 300.milliseconds
+    }
+}
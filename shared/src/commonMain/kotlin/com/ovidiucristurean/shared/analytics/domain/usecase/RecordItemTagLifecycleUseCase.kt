@@ -0,0 +1,19 @@
+package com.ovidiucristurean.shared.analytics.domain.usecase
+
+import com.ovidiucristurean.shared.analytics.domain.model.ItemTagLifecycle
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+
+/**
+ * Feeds completed item tags into the service time sketches. Call it once per tag, when it is
+ * completed.
+ */
+class RecordItemTagLifecycleUseCase(private val repository: AnalyticsRepository) {
+    suspend operator fun invoke(lifecycle: ItemTagLifecycle) {
+        repository.recordItemTagLifecycles(listOf(lifecycle))
+    }
+
+    suspend operator fun invoke(lifecycles: List<ItemTagLifecycle>) {
+        if (lifecycles.isEmpty()) return
+        repository.recordItemTagLifecycles(lifecycles)
+    }
+}
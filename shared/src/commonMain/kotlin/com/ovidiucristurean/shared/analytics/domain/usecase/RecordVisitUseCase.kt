@@ -7,4 +7,9 @@ class RecordVisitUseCase(private val repository: AnalyticsRepository) {
     suspend operator fun invoke(event: VisitEvent) {
         repository.recordVisit(event)
     }
+
+    suspend operator fun invoke(events: List<VisitEvent>) {
+        if (events.isEmpty()) return
+        repository.recordVisits(events)
+    }
 }
@@ -3,33 +3,218 @@ package com.ovidiucristurean.shared.analytics.presentation
 import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
 import com.ovidiucristurean.shared.analytics.domain.usecase.RecordVisitUseCase
 import com.ovidiucristurean.shared.analytics.logMessage
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineDispatcher
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.ExperimentalCoroutinesApi
+import kotlinx.coroutines.channels.BufferOverflow
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.flow.update
+import kotlinx.coroutines.flow.updateAndGet
 import kotlinx.coroutines.launch
+import kotlinx.coroutines.selects.onTimeout
+import kotlinx.coroutines.selects.select
 import kotlinx.datetime.Clock
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.seconds
+import kotlin.time.TimeMark
+import kotlin.time.TimeSource
 
 interface AnalyticsTracker {
-    fun trackVisit(shopId: String)
+    /**
+     * Running delivery totals, so callers can watch for dropped or failed visits.
+     */
+    val stats: StateFlow<AnalyticsTrackerStats>
+
+    fun trackVisit(shopId: String) {
+        trackVisit(shopId, visitorKey = null)
+    }
+
+    /**
+     * Like [trackVisit], for a customer identified by [visitorKey], so that unique visitors can be
+     * estimated. Pass a pseudonymous key, such as a hashed loyalty card number.
+     */
+    fun trackVisit(shopId: String, visitorKey: String?)
+
+    /**
+     * Commits every visit tracked so far. Call it when the app goes to the background.
+     */
+    suspend fun flush()
 }
 
+/**
+ * Running totals of a [DefaultAnalyticsTracker]. Every tracked visit is counted in [enqueued],
+ * and ends up in exactly one of [committed], [dropped] or [failed].
+ */
+data class AnalyticsTrackerStats(
+    val enqueued: Long = 0,
+    val committed: Long = 0,
+    val dropped: Long = 0,
+    val failed: Long = 0
+)
+
+/**
+ * Buffers visits in a bounded channel and lets a single consumer write them in batches, so a
+ * burst of scans costs one transaction instead of one per visit. A batch is committed once it
+ * holds [maxBatchSize] visits, once [flushInterval] has passed since its first visit, or when
+ * [flush] is called.
+ *
+ * At most [bufferCapacity] visits wait in memory. [onBufferOverflow] decides what happens when a
+ * burst fills the buffer. [BufferOverflow.DROP_OLDEST] and [BufferOverflow.DROP_LATEST] discard
+ * a visit. With [BufferOverflow.SUSPEND], [trackVisitAndWait] waits for room. [trackVisit] never
+ * blocks, so under that policy it drops the visit instead.
+ */
 class DefaultAnalyticsTracker(
   private val recordVisit: RecordVisitUseCase,
   private val scope: CoroutineScope,
-  private val clock: Clock = Clock.System
+  private val clock: Clock = Clock.System,
+  private val maxBatchSize: Int = DEFAULT_MAX_BATCH_SIZE,
+  private val flushInterval: Duration = DEFAULT_FLUSH_INTERVAL,
+  bufferCapacity: Int = DEFAULT_BUFFER_CAPACITY,
+  onBufferOverflow: BufferOverflow = BufferOverflow.SUSPEND,
+  private val timeSource: TimeSource = TimeSource.Monotonic,
+  dispatcher: CoroutineDispatcher = Dispatchers.Default
 ) : AnalyticsTracker {
+    // A full DROP_LATEST channel discards the new visit yet reports the send as successful, and
+    // tells onUndeliveredElement only for send(). So that policy is applied here instead: the
+    // channel suspends, and a trySend that fails is the dropped visit.
+    private val dropsLatest = onBufferOverflow == BufferOverflow.DROP_LATEST
+    private val events = Channel<VisitEvent>(
+        capacity = bufferCapacity,
+        onBufferOverflow = if (dropsLatest) BufferOverflow.SUSPEND else onBufferOverflow,
+        onUndeliveredElement = { countDropped() }
+    )
+    private val flushRequests = Channel<CompletableDeferred<Unit>>(Channel.UNLIMITED)
+
+    private val _stats = MutableStateFlow(AnalyticsTrackerStats())
+    override val stats: StateFlow<AnalyticsTrackerStats> = _stats.asStateFlow()
+
+    init {
+        require(maxBatchSize > 0) { "maxBatchSize must be positive" }
+        scope.launch(dispatcher) { consume() }
+    }
 
-    override fun trackVisit(shopId: String) {
+    override fun trackVisit(shopId: String, visitorKey: String?) {
       logMessage("trackVisit called from AnalyticsTracker")
-        scope.launch(Dispatchers.Default) {
+        _stats.update { it.copy(enqueued = it.enqueued + 1) }
+        if (events.trySend(newVisit(shopId, visitorKey)).isFailure) {
+            countDropped()
+        }
+    }
+
+    /**
+     * Like [trackVisit], but waits for room in the buffer when it is full and the overflow policy
+     * is [BufferOverflow.SUSPEND]. For callers that can afford to wait, never the UI thread.
+     */
+    suspend fun trackVisitAndWait(shopId: String, visitorKey: String? = null) {
+        if (dropsLatest) return trackVisit(shopId, visitorKey)
+        _stats.update { it.copy(enqueued = it.enqueued + 1) }
+        events.send(newVisit(shopId, visitorKey))
+    }
+
+    /**
+     * Returns without committing once the consumer has stopped, because its scope was cancelled
+     * or it failed. The visits it still held are counted as dropped.
+     */
+    override suspend fun flush() {
+        val done = CompletableDeferred<Unit>()
+        if (flushRequests.trySend(done).isFailure) return
+        done.await()
+    }
+
+    @OptIn(ExperimentalCoroutinesApi::class)
+    private suspend fun consume() {
+        val batch = ArrayList<VisitEvent>(maxBatchSize)
+        var deadline: TimeMark? = null
+        var flushRequest: CompletableDeferred<Unit>? = null
+
+        try {
+            while (true) {
+                val currentDeadline = deadline
+
+                select<Unit> {
+                    events.onReceive { event ->
+                        if (batch.isEmpty()) {
+                            deadline = timeSource.markNow() + flushInterval
+                        }
+                        batch.add(event)
+                    }
+                    flushRequests.onReceive { flushRequest = it }
+                    if (currentDeadline != null) {
+                        onTimeout(-currentDeadline.elapsedNow()) {}
+                    }
+                }
+
+                if (flushRequest != null) {
+                    // Everything tracked before flush() was called is already in the channel.
+                    while (true) {
+                        batch.add(events.tryReceive().getOrNull() ?: break)
+                    }
+                }
+
+                val isDue = deadline?.hasPassedNow() == true
+                if (batch.size >= maxBatchSize || isDue || flushRequest != null) {
+                    commit(batch)
+                    deadline = null
+                }
+                flushRequest?.complete(Unit)
+                flushRequest = null
+            }
+        } finally {
+            // Nothing reads the channels any more, so later sends fail instead of waiting.
+            // Cancelling [events] counts its buffered visits as dropped; the unsaved batch is too.
+            flushRequests.close()
+            events.cancel()
+            _stats.update { it.copy(dropped = it.dropped + batch.size) }
+            flushRequest?.complete(Unit)
+            while (true) {
+                (flushRequests.tryReceive().getOrNull() ?: break).complete(Unit)
+            }
+        }
+    }
+
+    private fun newVisit(shopId: String, visitorKey: String?) = VisitEvent(
+        shopId = shopId,
+        timestamp = clock.now(),
+        visitorKey = visitorKey
+    )
+
+    private fun countDropped() {
+        val dropped = _stats.updateAndGet { it.copy(dropped = it.dropped + 1) }.dropped
+        // Logging every visit would flood the log during exactly the bursts that drop them.
+        if (dropped == 1L || dropped % DROP_LOG_INTERVAL == 0L) {
+            logMessage("Analytics buffer is full, $dropped visits dropped so far")
+        }
+    }
+
+    // Each chunk leaves [batch] once it is accounted for, so a commit that is cancelled or throws
+    // leaves exactly the visits that were neither committed nor counted as failed.
+    private suspend fun commit(batch: MutableList<VisitEvent>) {
+        while (batch.isNotEmpty()) {
+            val chunk = batch.subList(0, minOf(maxBatchSize, batch.size))
             try {
-                val event = VisitEvent(
-                    shopId = shopId,
-                    timestamp = clock.now()
-                )
-                recordVisit(event)
+                recordVisit(chunk.toList())
+                _stats.update { it.copy(committed = it.committed + chunk.size) }
+            } catch (e: CancellationException) {
+                throw e
             } catch (e: Exception) {
-                // Fail silently for analytics
+                // Analytics must not crash the app, but the loss should still be visible.
+                _stats.update { it.copy(failed = it.failed + chunk.size) }
+                logMessage("Failed to store ${chunk.size} visits: ${e.message}")
             }
+            chunk.clear()
         }
     }
+
+    companion object {
+        const val DEFAULT_MAX_BATCH_SIZE = 256
+        const val DEFAULT_BUFFER_CAPACITY = 4096
+        val DEFAULT_FLUSH_INTERVAL = 2.seconds
+        private const val DROP_LOG_INTERVAL = 1000L
+    }
 }
@@ -1,14 +1,21 @@
 package com.ovidiucristurean.shared.di
 
+import com.ovidiucristurean.shared.analytics.data.repository.JournaledAnalyticsRepository
 import com.ovidiucristurean.shared.analytics.data.repository.RoomAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.data.retention.VisitRetentionEngine
 import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.usecase.GetShopStatisticsUseCase
+import com.ovidiucristurean.shared.analytics.domain.usecase.RecordItemTagLifecycleUseCase
 import com.ovidiucristurean.shared.analytics.domain.usecase.RecordVisitUseCase
 import com.ovidiucristurean.shared.analytics.presentation.AnalyticsTracker
 import com.ovidiucristurean.shared.analytics.presentation.DefaultAnalyticsTracker
 import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.SupervisorJob
+import kotlinx.datetime.TimeZone
 import org.koin.core.context.startKoin
 import org.koin.core.module.Module
+import org.koin.core.qualifier.named
 import org.koin.dsl.KoinAppDeclaration
 import org.koin.dsl.module
 
@@ -23,8 +30,25 @@ fun initKoin(appDeclaration: KoinAppDeclaration = {}) =
 
 @Throws(Exception::class)
 fun commonModule() = module {
-  single<AnalyticsRepository> { RoomAnalyticsRepository(get()) }
+  single {
+    RoomAnalyticsRepository(
+      database = get(),
+      rollupTimeZone = TimeZone.currentSystemDefault()
+    )
+  }
+  single<AnalyticsRepository> {
+    JournaledAnalyticsRepository(
+      room = get(),
+      journal = get(),
+      scope = CoroutineScope(SupervisorJob() + Dispatchers.Default),
+      ioDispatcher = get(named(ANALYTICS_IO_DISPATCHER))
+    )
+  }
+  single { VisitRetentionEngine(database = get(), repository = get()) }
   single { RecordVisitUseCase(get()) }
+  single { RecordItemTagLifecycleUseCase(get()) }
+  // Stateful, so every consumer gets its own instance to keep.
+  factory { GetShopStatisticsUseCase(get()) }
   single<AnalyticsTracker> {
     DefaultAnalyticsTracker(
       recordVisit = get(),
@@ -33,4 +57,7 @@ fun commonModule() = module {
   }
 }
 
+// Platform modules provide a CoroutineDispatcher under this name for blocking file and database I/O.
+const val ANALYTICS_IO_DISPATCHER = "analyticsIoDispatcher"
+
 expect fun platformModule(): Module
@@ -1,22 +1,46 @@
 package com.ovidiucristurean.shared.analytics
 
 import com.ovidiucristurean.shared.analytics.data.repository.InMemoryAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.model.ItemTagLifecycle
+import com.ovidiucristurean.shared.analytics.domain.model.ShopStatistics
+import com.ovidiucristurean.shared.analytics.domain.model.TrendPeriod
 import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.statistics.ShopStatisticsEngine
+import com.ovidiucristurean.shared.analytics.domain.usecase.GetServiceTimeQuantilesUseCase
 import com.ovidiucristurean.shared.analytics.domain.usecase.GetShopStatisticsUseCase
+import com.ovidiucristurean.shared.analytics.domain.usecase.GetStatisticsForShopsUseCase
+import com.ovidiucristurean.shared.analytics.domain.usecase.GetUniqueVisitorsUseCase
+import com.ovidiucristurean.shared.analytics.domain.usecase.GetVisitHeatmapUseCase
+import com.ovidiucristurean.shared.analytics.domain.usecase.GetVisitTrendUseCase
 import com.ovidiucristurean.shared.analytics.domain.usecase.GetWeeklyTrendUseCase
+import com.ovidiucristurean.shared.analytics.domain.usecase.ObserveShopStatisticsUseCase
+import com.ovidiucristurean.shared.analytics.domain.usecase.RecordItemTagLifecycleUseCase
 import com.ovidiucristurean.shared.analytics.domain.usecase.RecordVisitUseCase
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.test.advanceTimeBy
 import kotlinx.coroutines.test.runTest
 import kotlinx.datetime.DateTimeUnit
 import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
 import kotlinx.datetime.TimeZone
 import kotlinx.datetime.minus
 import kotlinx.datetime.plus
+import kotlin.math.abs
 import kotlin.test.BeforeTest
 import kotlin.test.Test
+import kotlin.test.assertContentEquals
 import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.minutes
+import kotlin.time.Duration.Companion.seconds
 
-class AnalyticsTest {
-    private lateinit var repository: InMemoryAnalyticsRepository
+open class AnalyticsTest {
+    private lateinit var repository: AnalyticsRepository
     private lateinit var recordVisitUseCase: RecordVisitUseCase
     private lateinit var getShopStatisticsUseCase: GetShopStatisticsUseCase
     private lateinit var getWeeklyTrendUseCase: GetWeeklyTrendUseCase
@@ -25,9 +49,11 @@ class AnalyticsTest {
     private val timeZone = TimeZone.UTC
     private val baseTime = Instant.parse("2024-01-10T10:00:00Z")
 
+    open fun createRepository(): AnalyticsRepository = InMemoryAnalyticsRepository()
+
     @BeforeTest
     fun setup() {
-        repository = InMemoryAnalyticsRepository()
+        repository = createRepository()
         recordVisitUseCase = RecordVisitUseCase(repository)
         getShopStatisticsUseCase = GetShopStatisticsUseCase(repository)
         getWeeklyTrendUseCase = GetWeeklyTrendUseCase(repository)
@@ -51,6 +77,274 @@ class AnalyticsTest {
         assertEquals(1.0, stats.averagePerDay) // 3 visits / 3 days
     }
 
+    @Test
+    fun testRecordVisitsInBatch() = runTest {
+        val from = baseTime
+        val to = baseTime.plus(1, DateTimeUnit.DAY, timeZone)
+
+        recordVisitUseCase(
+            listOf(
+                VisitEvent(shopId, baseTime),
+                VisitEvent(shopId, baseTime.plus(1, DateTimeUnit.HOUR, timeZone)),
+                VisitEvent("other-shop", baseTime),
+                VisitEvent(shopId, to)
+            )
+        )
+
+        val stats = getShopStatisticsUseCase(shopId, from, to, timeZone)
+
+        assertEquals(3, stats.totalVisits)
+    }
+
+    @Test
+    fun testGetVisitsPaged() = runTest {
+        val from = baseTime
+        val to = baseTime.plus(1, DateTimeUnit.HOUR, timeZone)
+        recordVisitUseCase(
+            List(7) { VisitEvent(shopId, baseTime.plus(it, DateTimeUnit.MINUTE, timeZone)) } +
+                VisitEvent(shopId, to.plus(1, DateTimeUnit.MINUTE, timeZone))
+        )
+
+        val pages = repository.getVisitsPaged(shopId, from, to, pageSize = 3).toList()
+
+        assertEquals(listOf(3, 3, 1), pages.map { it.size })
+        assertEquals(repository.getVisits(shopId, from, to), pages.flatten())
+    }
+
+    @Test
+    fun testObserveShopStatistics() = runTest {
+        val from = baseTime
+        val to = baseTime.plus(1, DateTimeUnit.DAY, timeZone)
+        val emissions = mutableListOf<ShopStatistics>()
+        recordVisitUseCase(VisitEvent(shopId, baseTime))
+
+        backgroundScope.launch {
+            ObserveShopStatisticsUseCase(repository)(shopId, from, to, timeZone).toList(emissions)
+        }
+        advanceTimeBy(1.seconds)
+        assertEquals(listOf(1), emissions.map { it.totalVisits })
+
+        recordVisitUseCase(
+            listOf(
+                VisitEvent(shopId, baseTime.plus(1, DateTimeUnit.HOUR, timeZone)),
+                VisitEvent("other-shop", baseTime)
+            )
+        )
+        advanceTimeBy(1.seconds)
+        assertEquals(listOf(1, 2), emissions.map { it.totalVisits })
+
+        // Arrives out of order, between two visits already counted.
+        recordVisitUseCase(VisitEvent(shopId, baseTime.plus(30, DateTimeUnit.MINUTE, timeZone)))
+        advanceTimeBy(1.seconds)
+        assertEquals(listOf(1, 2, 3), emissions.map { it.totalVisits })
+        assertEquals(3, emissions.last().dailyBreakdown[LocalDate(2024, 1, 10)])
+    }
+
+    @Test
+    fun testRepeatedStatisticsWithMovingWindow() = runTest {
+        var from = baseTime
+        var to = baseTime.plus(2, DateTimeUnit.DAY, timeZone)
+        recordVisitUseCase(
+            List(5) { VisitEvent(shopId, baseTime.plus(it * 10, DateTimeUnit.HOUR, timeZone)) }
+        )
+        assertEquals(5, getShopStatisticsUseCase(shopId, from, to, timeZone).totalVisits)
+
+        recordVisitUseCase(VisitEvent(shopId, baseTime.plus(3, DateTimeUnit.HOUR, timeZone)))
+        from = from.plus(2, DateTimeUnit.HOUR, timeZone)
+        to = to.plus(12, DateTimeUnit.HOUR, timeZone)
+        recordVisitUseCase(VisitEvent(shopId, to))
+
+        val stats = getShopStatisticsUseCase(shopId, from, to, timeZone)
+        assertEquals(GetShopStatisticsUseCase(repository)(shopId, from, to, timeZone), stats)
+        assertEquals(6, stats.totalVisits)
+    }
+
+    @Test
+    fun testRefreshWithoutConcurrentWritesTrustsTheDelta() = runTest {
+        val from = baseTime
+        val to = baseTime.plus(2, DateTimeUnit.DAY, timeZone)
+        val counting = CountingRepository(repository)
+        val engine = ShopStatisticsEngine(counting)
+        recordVisitUseCase(List(2) { VisitEvent(shopId, baseTime) })
+        engine.statistics(shopId, from, to, timeZone)
+
+        recordVisitUseCase(VisitEvent(shopId, baseTime.plus(1, DateTimeUnit.HOUR, timeZone)))
+
+        assertEquals(3, engine.statistics(shopId, from, to, timeZone).totalVisits)
+        assertEquals(1, counting.rangeQueries)
+    }
+
+    @Test
+    fun testVisitRecordedDuringRecomputeIsNotCountedTwice() = runTest {
+        val from = baseTime
+        val to = baseTime.plus(2, DateTimeUnit.DAY, timeZone)
+        val counting = CountingRepository(repository)
+        val engine = ShopStatisticsEngine(counting)
+        recordVisitUseCase(List(2) { VisitEvent(shopId, baseTime) })
+        counting.beforeRangeQuery = {
+            counting.beforeRangeQuery = null
+            recordVisitUseCase(VisitEvent(shopId, baseTime.plus(1, DateTimeUnit.HOUR, timeZone)))
+        }
+
+        assertEquals(3, engine.statistics(shopId, from, to, timeZone).totalVisits)
+        assertEquals(2, counting.rangeQueries)
+        assertEquals(3, engine.statistics(shopId, from, to, timeZone).totalVisits)
+        assertEquals(2, counting.rangeQueries)
+    }
+
+    @Test
+    fun testVisitRecordedWhileTheWindowMovesIsNotMiscounted() = runTest {
+        val from = baseTime
+        val to = baseTime.plus(2, DateTimeUnit.DAY, timeZone)
+        val counting = CountingRepository(repository)
+        val engine = ShopStatisticsEngine(counting)
+        val visitTime = baseTime.plus(3, DateTimeUnit.HOUR, timeZone)
+        recordVisitUseCase(List(2) { VisitEvent(shopId, visitTime) })
+        engine.statistics(shopId, from, to, timeZone)
+
+        // Lands in the sliver that leaves the window, while that sliver is being counted.
+        counting.beforeRangeQuery = {
+            counting.beforeRangeQuery = null
+            recordVisitUseCase(VisitEvent(shopId, baseTime.plus(1, DateTimeUnit.HOUR, timeZone)))
+        }
+        val movedFrom = from.plus(2, DateTimeUnit.HOUR, timeZone)
+
+        assertEquals(
+            GetShopStatisticsUseCase(repository)(shopId, movedFrom, to, timeZone),
+            engine.statistics(shopId, movedFrom, to, timeZone)
+        )
+        assertEquals(2, engine.statistics(shopId, movedFrom, to, timeZone).totalVisits)
+    }
+
+    @Test
+    fun testStatisticsForShops() = runTest {
+        val from = baseTime
+        val to = baseTime.plus(2, DateTimeUnit.DAY, timeZone)
+        recordVisitUseCase(
+            listOf(
+                VisitEvent(shopId, baseTime),
+                VisitEvent(shopId, baseTime.plus(1, DateTimeUnit.DAY, timeZone)),
+                VisitEvent("other-shop", baseTime),
+                VisitEvent("ignored-shop", baseTime)
+            )
+        )
+
+        val shopIds = listOf(shopId, "other-shop", "empty-shop")
+        val stats = GetStatisticsForShopsUseCase(repository)(shopIds, from, to, timeZone)
+
+        assertEquals(shopIds.toSet(), stats.keys)
+        shopIds.forEach { id ->
+            assertEquals(getShopStatisticsUseCase(id, from, to, timeZone), stats.getValue(id))
+        }
+        assertEquals(listOf(2, 1, 0), shopIds.map { stats.getValue(it).totalVisits })
+    }
+
+    @Test
+    fun testDailyBreakdownAcrossDstTransition() = runTest {
+        val newYork = TimeZone.of("America/New_York")
+        // Clocks spring forward at 02:00 on 2024-03-10, so that local day is only 23 hours long.
+        val from = Instant.parse("2024-03-09T17:00:00Z")
+        val to = Instant.parse("2024-03-11T17:00:00Z")
+
+        recordVisitUseCase(VisitEvent(shopId, Instant.parse("2024-03-10T04:59:00Z"))) // 03-09 23:59 EST
+        recordVisitUseCase(VisitEvent(shopId, Instant.parse("2024-03-10T05:30:00Z"))) // 03-10 00:30 EST
+        recordVisitUseCase(VisitEvent(shopId, Instant.parse("2024-03-11T03:30:00Z"))) // 03-10 23:30 EDT
+        recordVisitUseCase(VisitEvent(shopId, Instant.parse("2024-03-11T04:30:00Z"))) // 03-11 00:30 EDT
+
+        val stats = getShopStatisticsUseCase(shopId, from, to, newYork)
+
+        assertEquals(4, stats.totalVisits)
+        assertEquals(1, stats.dailyBreakdown[LocalDate(2024, 3, 9)])
+        assertEquals(2, stats.dailyBreakdown[LocalDate(2024, 3, 10)])
+        assertEquals(1, stats.dailyBreakdown[LocalDate(2024, 3, 11)])
+    }
+
+    @Test
+    fun testVisitHeatmapAcrossDstTransition() = runTest {
+        val newYork = TimeZone.of("America/New_York")
+        val from = Instant.parse("2024-03-08T00:00:00Z")
+        val to = Instant.parse("2024-03-12T00:00:00Z")
+
+        listOf(
+            "2024-03-09T04:59:00Z", // Fri 23:59 EST
+            "2024-03-10T05:30:00Z", // Sun 00:30 EST
+            "2024-03-11T03:30:00Z", // Sun 23:30 EDT
+            "2024-03-11T13:15:00Z", // Mon 09:15 EDT
+            "2024-03-11T13:45:00Z", // Mon 09:45 EDT
+        ).forEach { recordVisitUseCase(VisitEvent(shopId, Instant.parse(it))) }
+
+        val heatmap = GetVisitHeatmapUseCase(repository)(shopId, from, to, newYork)
+
+        val expected = IntArray(168).apply {
+            this[4 * 24 + 23] = 1
+            this[6 * 24 + 0] = 1
+            this[6 * 24 + 23] = 1
+            this[0 * 24 + 9] = 2
+        }
+        assertContentEquals(expected, heatmap)
+    }
+
+    @Test
+    fun testUniqueVisitors() = runTest {
+        val day1 = Instant.parse("2024-01-10T08:00:00Z")
+        val day2 = Instant.parse("2024-01-11T08:00:00Z")
+        // 50 customers twice on day 1, 50 on day 2 of whom 25 came back, and anonymous visits.
+        val firstDayVisits = (0 until 50).flatMap { index ->
+            List(2) { VisitEvent(shopId, day1, "visitor-$index") }
+        }
+        val secondDayVisits = (25 until 75).map { VisitEvent(shopId, day2, "visitor-$it") }
+        recordVisitUseCase(firstDayVisits + secondDayVisits + List(10) { VisitEvent(shopId, day2) })
+        val getUniqueVisitors = GetUniqueVisitorsUseCase(repository)
+
+        assertApproximately(50, getUniqueVisitors(shopId, day1, day1))
+        assertApproximately(75, getUniqueVisitors(shopId, day1, day2))
+        // Sketches are per day, so a range starting after the visits still covers the whole day.
+        val afterVisits = day2.plus(1, DateTimeUnit.HOUR)
+        assertApproximately(50, getUniqueVisitors(shopId, afterVisits, afterVisits))
+        assertEquals(0L, getUniqueVisitors("other-shop", day1, day2))
+    }
+
+    private fun assertApproximately(expected: Int, actual: Long) {
+        assertTrue(abs(actual - expected) <= 2, "expected about $expected, was $actual")
+    }
+
+    @Test
+    fun testServiceTimeQuantiles() = runTest {
+        val completedAt = Instant.parse("2024-01-10T12:00:00Z")
+        // Tag n waited n minutes since creation; every even tag was read n / 2 minutes before.
+        val lifecycles = (1..100).map { n ->
+            ItemTagLifecycle(
+                shopId = shopId,
+                createdAt = completedAt - n.minutes,
+                customerReadAt = if (n % 2 == 0) completedAt - (n / 2).minutes else null,
+                completedAt = completedAt
+            )
+        }
+        // Completed before it was created, as when device clocks disagree.
+        val skewed = ItemTagLifecycle(shopId, completedAt, null, completedAt - 1.minutes)
+        RecordItemTagLifecycleUseCase(repository)(lifecycles + skewed)
+        val getServiceTimes = GetServiceTimeQuantilesUseCase(repository)
+
+        val statistics = getServiceTimes(shopId, completedAt, completedAt)
+        val createdToCompleted = statistics.createdToCompleted!!
+        assertEquals(100L, createdToCompleted.sampleCount)
+        assertApproximately(50.5.minutes, createdToCompleted.p50)
+        assertApproximately(90.5.minutes, createdToCompleted.p90)
+        assertApproximately(99.5.minutes, createdToCompleted.p99)
+        val readToCompleted = statistics.readToCompleted!!
+        assertEquals(50L, readToCompleted.sampleCount)
+        assertApproximately(25.5.minutes, readToCompleted.p50)
+
+        val nextDay = completedAt.plus(1, DateTimeUnit.DAY, timeZone)
+        assertNull(getServiceTimes(shopId, nextDay, nextDay).createdToCompleted)
+        assertNull(getServiceTimes("other-shop", completedAt, completedAt).readToCompleted)
+    }
+
+    private fun assertApproximately(expected: Duration, actual: Duration) {
+        val error = (actual - expected).absoluteValue
+        assertTrue(error <= 1.minutes, "expected about $expected, was $actual")
+    }
+
     @Test
     fun testZeroVisitAverage() = runTest {
         val from = baseTime
@@ -118,4 +412,52 @@ class AnalyticsTest {
         trend = getWeeklyTrendUseCase(shopId, now, timeZone)
         assertEquals(100.0, trend.percentageChange)
     }
+
+    @Test
+    fun testMonthlyTrendSeries() = runTest {
+        val now = Instant.parse("2024-04-15T10:00:00Z")
+        val visitCounts = mapOf(
+            "2023-12-20" to 1,
+            "2024-01-20" to 2,
+            "2024-02-20" to 4,
+            "2024-03-20" to 1
+        )
+        visitCounts.forEach { (date, count) ->
+            val timestamp = Instant.parse("${date}T12:00:00Z")
+            recordVisitUseCase(List(count) { VisitEvent(shopId, timestamp) })
+        }
+        // The current period includes now itself.
+        recordVisitUseCase(VisitEvent(shopId, now))
+        val getVisitTrend = GetVisitTrendUseCase(repository)
+
+        val trend = getVisitTrend(shopId, now, TrendPeriod.MONTH, periodCount = 3, timeZone)
+
+        assertEquals(listOf(2, 4, 2), trend.periods.map { it.visits })
+        assertEquals(listOf(1, 2, 4), trend.periods.map { it.previousVisits })
+        assertEquals(listOf(100.0, 100.0, -50.0), trend.periods.map { it.percentageChange })
+        assertEquals(now, trend.periods.last().to)
+        assertEquals(Instant.parse("2024-03-15T10:00:00.001Z"), trend.periods.last().from)
+        assertFailsWith<IllegalArgumentException> {
+            getVisitTrend(shopId, now, TrendPeriod.DAY, periodCount = 13, timeZone)
+        }
+    }
+}
+
+// Counts the range queries of ShopStatisticsEngine and can write in the middle of one.
+private class CountingRepository(
+    private val delegate: AnalyticsRepository
+) : AnalyticsRepository by delegate {
+    var rangeQueries = 0
+    var beforeRangeQuery: (suspend () -> Unit)? = null
+
+    override suspend fun getDailyVisitCounts(
+        shopId: String,
+        from: Instant,
+        to: Instant,
+        timeZone: TimeZone
+    ): Map<LocalDate, Int> {
+        rangeQueries++
+        beforeRangeQuery?.invoke()
+        return delegate.getDailyVisitCounts(shopId, from, to, timeZone)
+    }
 }
@@ -0,0 +1,164 @@
+package com.ovidiucristurean.shared.analytics
+
+import com.ovidiucristurean.shared.analytics.data.repository.InMemoryAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.usecase.RecordVisitUseCase
+import com.ovidiucristurean.shared.analytics.presentation.AnalyticsTrackerStats
+import com.ovidiucristurean.shared.analytics.presentation.DefaultAnalyticsTracker
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.ExperimentalCoroutinesApi
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.channels.BufferOverflow
+import kotlinx.coroutines.test.StandardTestDispatcher
+import kotlinx.coroutines.test.TestScope
+import kotlinx.coroutines.test.advanceTimeBy
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import kotlinx.datetime.Clock
+import kotlinx.datetime.Instant
+import kotlin.test.BeforeTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.time.Duration.Companion.seconds
+
+@OptIn(ExperimentalCoroutinesApi::class)
+class AnalyticsTrackerTest {
+    private lateinit var repository: InMemoryAnalyticsRepository
+
+    private val shopId = "test-shop"
+    private val now = Instant.parse("2024-01-10T10:00:00Z")
+    private val clock = object : Clock {
+        override fun now(): Instant = now
+    }
+
+    @BeforeTest
+    fun setup() {
+        repository = InMemoryAnalyticsRepository()
+    }
+
+    private fun TestScope.createTracker(
+        maxBatchSize: Int = 10,
+        bufferCapacity: Int = DefaultAnalyticsTracker.DEFAULT_BUFFER_CAPACITY,
+        onBufferOverflow: BufferOverflow = BufferOverflow.SUSPEND,
+        repository: AnalyticsRepository = this@AnalyticsTrackerTest.repository
+    ) = DefaultAnalyticsTracker(
+        recordVisit = RecordVisitUseCase(repository),
+        scope = backgroundScope,
+        clock = clock,
+        maxBatchSize = maxBatchSize,
+        flushInterval = 5.seconds,
+        bufferCapacity = bufferCapacity,
+        onBufferOverflow = onBufferOverflow,
+        timeSource = testScheduler.timeSource,
+        dispatcher = StandardTestDispatcher(testScheduler)
+    )
+
+    private suspend fun storedVisits() = repository.getVisits(shopId, now, now).size
+
+    @Test
+    fun testBatchIsCommittedWhenFull() = runTest {
+        val tracker = createTracker(maxBatchSize = 3)
+
+        repeat(2) { tracker.trackVisit(shopId) }
+        runCurrent()
+        assertEquals(0, storedVisits())
+
+        tracker.trackVisit(shopId)
+        runCurrent()
+        assertEquals(3, storedVisits())
+    }
+
+    @Test
+    fun testBatchIsCommittedAfterFlushInterval() = runTest {
+        val tracker = createTracker()
+
+        tracker.trackVisit(shopId)
+        advanceTimeBy(4.seconds)
+        assertEquals(0, storedVisits())
+
+        advanceTimeBy(2.seconds)
+        assertEquals(1, storedVisits())
+    }
+
+    @Test
+    fun testFlushCommitsPendingVisits() = runTest {
+        val tracker = createTracker()
+
+        repeat(25) { tracker.trackVisit(shopId) }
+        tracker.flush()
+
+        assertEquals(25, storedVisits())
+    }
+
+    @Test
+    fun testOverflowPolicies() = runTest {
+        BufferOverflow.entries.forEach { policy ->
+            val tracker = createTracker(bufferCapacity = 2, onBufferOverflow = policy)
+
+            // The consumer has not run yet, so only two visits fit.
+            repeat(5) { tracker.trackVisit(shopId) }
+            tracker.flush()
+
+            assertEquals(
+                AnalyticsTrackerStats(enqueued = 5, committed = 2, dropped = 3),
+                tracker.stats.value,
+                "policy $policy"
+            )
+        }
+    }
+
+    @Test
+    fun testTrackVisitAndWaitCountsDropsUnderDropPolicies() = runTest {
+        listOf(BufferOverflow.DROP_OLDEST, BufferOverflow.DROP_LATEST).forEach { policy ->
+            val tracker = createTracker(bufferCapacity = 2, onBufferOverflow = policy)
+
+            repeat(5) { tracker.trackVisitAndWait(shopId) }
+            tracker.flush()
+
+            assertEquals(
+                AnalyticsTrackerStats(enqueued = 5, committed = 2, dropped = 3),
+                tracker.stats.value,
+                "policy $policy"
+            )
+        }
+    }
+
+    @Test
+    fun testFailedCommitsAreCounted() = runTest {
+        val failingRepository = object : AnalyticsRepository by repository {
+            override suspend fun recordVisits(events: List<VisitEvent>) {
+                throw IllegalStateException("disk full")
+            }
+        }
+        val tracker = createTracker(maxBatchSize = 2, repository = failingRepository)
+
+        repeat(3) { tracker.trackVisit(shopId) }
+        tracker.flush()
+
+        assertEquals(AnalyticsTrackerStats(enqueued = 3, failed = 3), tracker.stats.value)
+    }
+
+    @Test
+    fun testFlushReturnsOnceTheConsumerIsGone() = runTest {
+        val trackerScope = CoroutineScope(Job())
+        val tracker = DefaultAnalyticsTracker(
+            recordVisit = RecordVisitUseCase(repository),
+            scope = trackerScope,
+            clock = clock,
+            timeSource = testScheduler.timeSource,
+            dispatcher = StandardTestDispatcher(testScheduler)
+        )
+        tracker.trackVisit(shopId)
+        runCurrent()
+
+        trackerScope.cancel()
+        runCurrent()
+        tracker.trackVisit(shopId)
+        tracker.flush()
+
+        assertEquals(AnalyticsTrackerStats(enqueued = 2, dropped = 2), tracker.stats.value)
+        assertEquals(0, storedVisits())
+    }
+}
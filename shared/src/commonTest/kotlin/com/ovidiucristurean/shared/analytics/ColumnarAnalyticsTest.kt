@@ -0,0 +1,8 @@
+package com.ovidiucristurean.shared.analytics
+
+import com.ovidiucristurean.shared.analytics.data.repository.ColumnarAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.repository.AnalyticsRepository
+
+class ColumnarAnalyticsTest : AnalyticsTest() {
+    override fun createRepository(): AnalyticsRepository = ColumnarAnalyticsRepository()
+}
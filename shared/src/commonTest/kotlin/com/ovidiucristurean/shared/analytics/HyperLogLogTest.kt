@@ -0,0 +1,50 @@
+package com.ovidiucristurean.shared.analytics
+
+import com.ovidiucristurean.shared.analytics.domain.sketch.HyperLogLog
+import kotlin.math.abs
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class HyperLogLogTest {
+    private fun sketchOf(keys: IntRange) = HyperLogLog().apply {
+        keys.forEach { add("visitor-$it") }
+    }
+
+    @Test
+    fun testEstimateIsWithinErrorBounds() {
+        listOf(10, 1_000, 100_000).forEach { distinct ->
+            val estimate = sketchOf(0 until distinct).estimate()
+            val relativeError = abs(estimate - distinct).toDouble() / distinct
+            // About three standard errors.
+            assertTrue(relativeError < 0.05, "distinct=$distinct estimate=$estimate")
+        }
+    }
+
+    @Test
+    fun testDuplicatesAreNotCounted() {
+        val sketch = sketchOf(0 until 500)
+        val before = sketch.toByteArray()
+
+        repeat(3) { (0 until 500).forEach { sketch.add("visitor-$it") } }
+
+        assertContentEquals(before, sketch.toByteArray())
+    }
+
+    @Test
+    fun testMergeEqualsSketchOfUnion() {
+        val merged = sketchOf(0 until 3_000).apply { merge(sketchOf(2_000 until 5_000)) }
+
+        assertContentEquals(sketchOf(0 until 5_000).toByteArray(), merged.toByteArray())
+    }
+
+    @Test
+    fun testRoundTripThroughBytes() {
+        val sketch = sketchOf(0 until 1_000)
+        val bytes = sketch.toByteArray()
+
+        assertEquals(HyperLogLog.SIZE_BYTES, bytes.size)
+        assertEquals(sketch.estimate(), HyperLogLog.fromByteArray(bytes).estimate())
+    }
+}
@@ -0,0 +1,65 @@
+package com.ovidiucristurean.shared.analytics
+
+import com.ovidiucristurean.shared.analytics.data.repository.InMemoryAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.test.runTest
+import kotlinx.coroutines.withContext
+import kotlinx.datetime.Instant
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.time.Duration.Companion.minutes
+
+class InMemoryAnalyticsRepositoryStressTest {
+    private val baseTime = Instant.parse("2024-01-10T10:00:00Z")
+    private val from = Instant.DISTANT_PAST
+    private val to = Instant.DISTANT_FUTURE
+
+    @Test
+    fun testParallelProducersAndConsumers() = runTest(timeout = 2.minutes) {
+        listOf(1, 2, 4, 8).forEach { parallelism ->
+            val repository = InMemoryAnalyticsRepository()
+
+            withContext(Dispatchers.Default) {
+                coroutineScope {
+                    repeat(parallelism) { producer ->
+                        launch { produce(repository, shopId = "shop-$producer") }
+                    }
+                    repeat(parallelism) { consumer ->
+                        launch { consume(repository, shopId = "shop-$consumer") }
+                    }
+                }
+            }
+
+            repeat(parallelism) { producer ->
+                assertEquals(
+                    EVENTS_PER_PRODUCER,
+                    repository.countVisits("shop-$producer", from, to)
+                )
+            }
+        }
+    }
+
+    private suspend fun produce(repository: InMemoryAnalyticsRepository, shopId: String) {
+        var millis = baseTime.toEpochMilliseconds()
+        repeat(EVENTS_PER_PRODUCER / BATCH_SIZE) {
+            repository.recordVisits(
+                List(BATCH_SIZE) { VisitEvent(shopId, Instant.fromEpochMilliseconds(millis++)) }
+            )
+        }
+    }
+
+    private suspend fun consume(repository: InMemoryAnalyticsRepository, shopId: String) {
+        repeat(QUERIES_PER_CONSUMER) {
+            repository.countVisits(shopId, from, to)
+        }
+    }
+
+    private companion object {
+        const val EVENTS_PER_PRODUCER = 50_000
+        const val BATCH_SIZE = 100
+        const val QUERIES_PER_CONSUMER = 5_000
+    }
+}
@@ -0,0 +1,75 @@
+package com.ovidiucristurean.shared.analytics
+
+import com.ovidiucristurean.shared.analytics.domain.sketch.TDigest
+import kotlin.math.abs
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class TDigestTest {
+    private val quantiles = listOf(0.01, 0.5, 0.9, 0.99)
+
+    private fun digestOf(values: List<Int>) = TDigest().apply {
+        values.forEach { add(it.toDouble()) }
+    }
+
+    // A shuffled permutation of 0 until size, so the exact q-quantile is q * size.
+    private fun shuffledValues(size: Int) = (0 until size).shuffled(Random(42))
+
+    @Test
+    fun testQuantilesAreWithinErrorBounds() {
+        val size = 100_000
+        val digest = digestOf(shuffledValues(size))
+
+        assertEquals(size.toLong(), digest.count)
+        quantiles.forEach { q ->
+            val error = abs(digest.quantile(q) - q * size) / size
+            assertTrue(error < 0.005, "q=$q estimate=${digest.quantile(q)}")
+        }
+        assertEquals(0.0, digest.quantile(0.0))
+        assertEquals(size - 1.0, digest.quantile(1.0))
+    }
+
+    @Test
+    fun testMergedDigestMatchesDigestOfAllValues() {
+        val size = 50_000
+        val values = shuffledValues(size)
+        val merged = TDigest()
+        values.chunked(size / 10).forEach { merged.merge(digestOf(it)) }
+
+        assertEquals(size.toLong(), merged.count)
+        quantiles.forEach { q ->
+            val error = abs(merged.quantile(q) - q * size) / size
+            assertTrue(error < 0.005, "q=$q estimate=${merged.quantile(q)}")
+        }
+    }
+
+    @Test
+    fun testSmallSamplesAreNearlyExact() {
+        val digest = digestOf((1..100).toList())
+
+        assertEquals(50.5, digest.quantile(0.5), absoluteTolerance = 1.0)
+        assertEquals(99.0, digest.quantile(0.99), absoluteTolerance = 1.0)
+    }
+
+    @Test
+    fun testRoundTripThroughBytes() {
+        val digest = digestOf(shuffledValues(10_000))
+        val bytes = digest.toByteArray()
+        val restored = TDigest.fromByteArray(bytes)
+
+        assertEquals(digest.count, restored.count)
+        quantiles.forEach { q -> assertEquals(digest.quantile(q), restored.quantile(q)) }
+        assertContentEquals(bytes, restored.toByteArray())
+    }
+
+    @Test
+    fun testEmptyDigest() {
+        val digest = TDigest.fromByteArray(TDigest().toByteArray())
+
+        assertEquals(0L, digest.count)
+        assertTrue(digest.quantile(0.5).isNaN())
+    }
+}
@@ -0,0 +1,98 @@
+package com.ovidiucristurean.shared.analytics
+
+import com.ovidiucristurean.shared.analytics.data.journal.JournalRecord
+import com.ovidiucristurean.shared.analytics.data.journal.VisitJournal
+import okio.Buffer
+import okio.Path.Companion.toPath
+import okio.fakefilesystem.FakeFileSystem
+import okio.use
+import kotlin.test.AfterTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class VisitJournalTest {
+    private val fileSystem = FakeFileSystem()
+    private val directory = "/journal".toPath()
+
+    @AfterTest
+    fun tearDown() {
+        fileSystem.checkNoOpenFiles()
+    }
+
+    private fun createJournal(minSegmentId: Long = 0) =
+        VisitJournal(fileSystem, directory, maxSegmentRecords = 3).apply { open(minSegmentId) }
+
+    private fun records(count: Int, shopKey: Long = 1) =
+        List(count) { JournalRecord(shopKey, epochMillis = 1_700_000_000_000 + it) }
+
+    private fun VisitJournal.readAll() = sealedSegments().flatMap { read(it) }
+        .map { it.shopKey to it.epochMillis }
+
+    @Test
+    fun testAppendedRecordsAreReadBackAcrossSegments() {
+        val journal = createJournal()
+        val written = records(7)
+
+        journal.append(written)
+        assertEquals(2, journal.sealedSegments().size)
+
+        journal.seal()
+        assertEquals(listOf(3, 3, 1), journal.sealedSegments().map { journal.read(it).size })
+        assertEquals(written.map { it.shopKey to it.epochMillis }, journal.readAll())
+    }
+
+    @Test
+    fun testVisitorHashesAreReadBack() {
+        val journal = createJournal()
+        journal.append(
+            listOf(
+                JournalRecord(shopKey = 1, epochMillis = 1, visitorHash = -42),
+                JournalRecord(shopKey = 2, epochMillis = 2),
+                JournalRecord(shopKey = Int.MAX_VALUE.toLong(), epochMillis = 3, visitorHash = 0),
+            )
+        )
+        journal.seal()
+
+        assertEquals(
+            listOf(
+                Triple(1L, 1L, -42L),
+                Triple(2L, 2L, null),
+                Triple(Int.MAX_VALUE.toLong(), 3L, 0L),
+            ),
+            journal.sealedSegments().flatMap { journal.read(it) }
+                .map { Triple(it.shopKey, it.epochMillis, it.visitorHash) }
+        )
+    }
+
+    @Test
+    fun testTornRecordEndsItsSegment() {
+        val journal = createJournal()
+        journal.append(records(2))
+        journal.seal()
+        val segment = journal.sealedSegments().single()
+
+        // A crash halfway through the third append leaves a few stray bytes behind.
+        fileSystem.appendingSink(segment.path).use { sink ->
+            sink.write(Buffer().writeInt(42), 4)
+        }
+
+        assertEquals(2, journal.read(segment).size)
+    }
+
+    @Test
+    fun testSegmentIdsAreNotReused() {
+        val journal = createJournal(minSegmentId = 5)
+        journal.append(records(1))
+        journal.seal()
+        val first = journal.sealedSegments().single()
+        journal.delete(first)
+
+        // After a restart, numbering continues from the checkpoint the drainer stored.
+        val reopened = createJournal(minSegmentId = first.id)
+        reopened.append(records(1))
+        reopened.seal()
+
+        assertEquals(6, first.id)
+        assertEquals(7, reopened.sealedSegments().single().id)
+    }
+}
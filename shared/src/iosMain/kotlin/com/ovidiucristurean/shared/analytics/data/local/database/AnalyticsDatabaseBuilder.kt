@@ -3,6 +3,8 @@ package com.ovidiucristurean.shared.analytics.data.local.database
 import androidx.room.Room
 import androidx.room.RoomDatabase
 import kotlinx.cinterop.ExperimentalForeignApi
+import okio.Path
+import okio.Path.Companion.toPath
 import platform.Foundation.NSDocumentDirectory
 import platform.Foundation.NSFileManager
 import platform.Foundation.NSUserDomainMask
@@ -14,6 +16,9 @@ fun getAnalyticsDatabaseBuilder(): RoomDatabase.Builder<AnalyticsDatabase> {
   )
 }
 
+fun getAnalyticsJournalDirectory(): Path =
+  (documentDirectory() + "/analytics-journal").toPath()
+
 @OptIn(ExperimentalForeignApi::class)
 private fun documentDirectory(): String {
   val documentDirectory = NSFileManager.defaultManager.URLForDirectory(
@@ -1,13 +1,28 @@
 package com.ovidiucristurean.shared.di
 
+import com.ovidiucristurean.shared.analytics.data.retention.RetentionReport
+import com.ovidiucristurean.shared.analytics.data.retention.VisitRetentionEngine
+import com.ovidiucristurean.shared.analytics.domain.usecase.RecordItemTagLifecycleUseCase
 import com.ovidiucristurean.shared.analytics.presentation.AnalyticsTracker
 import org.koin.core.component.KoinComponent
 import org.koin.core.component.inject
 
 class KoinHelper : KoinComponent {
     private val analyticsTracker: AnalyticsTracker by inject()
+    private val visitRetentionEngine: VisitRetentionEngine by inject()
+    private val recordItemTagLifecycle: RecordItemTagLifecycleUseCase by inject()
 
     fun getAnalyticsTracker(): AnalyticsTracker = analyticsTracker
+
+    fun getVisitRetentionEngine(): VisitRetentionEngine = visitRetentionEngine
+
+    /**
+     * Purges old raw visits. Nothing calls it on iOS by itself: the host app should run it
+     * about once a day, e.g. from a `BGProcessingTask` registered with `BGTaskScheduler`.
+     */
+    suspend fun runVisitRetention(): RetentionReport = visitRetentionEngine.run()
+
+    fun getRecordItemTagLifecycleUseCase(): RecordItemTagLifecycleUseCase = recordItemTagLifecycle
 }
 
 fun initKoinIos() = initKoin {}
@@ -0,0 +1,25 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.data.local.database.ANALYTICS_MIGRATIONS
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsStorageProfile
+import com.ovidiucristurean.shared.analytics.data.local.database.getAnalyticsDatabaseBuilder
+import com.ovidiucristurean.shared.analytics.data.local.database.setStorageProfile
+import kotlinx.coroutines.Dispatchers
+import okio.Path.Companion.toOkioPath
+import java.io.File
+import java.nio.file.Files
+
+internal actual fun createBenchmarkDatabase(
+    profile: AnalyticsStorageProfile
+): BenchmarkDatabase {
+    val dbFile = File.createTempFile("analytics-benchmark", ".db").also { it.delete() }
+    val database = getAnalyticsDatabaseBuilder(dbFile)
+        .setStorageProfile(profile)
+        .addMigrations(*ANALYTICS_MIGRATIONS)
+        .setQueryCoroutineContext(Dispatchers.IO)
+        .build()
+    val journalDirectory = Files.createTempDirectory("analytics-journal").toOkioPath()
+    return BenchmarkDatabase(database, journalDirectory) {
+        listOf("", "-wal", "-shm", "-journal").forEach { File(dbFile.path + it).delete() }
+    }
+}
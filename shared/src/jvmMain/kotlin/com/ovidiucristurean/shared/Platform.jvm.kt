@@ -0,0 +1,3 @@
+package com.ovidiucristurean.shared
+
+actual fun platform() = "JVM"
@@ -0,0 +1,5 @@
+package com.ovidiucristurean.shared.analytics
+
+actual fun logMessage(message: String) {
+    println("JVM_TO_KMP_APP - $message")
+}
@@ -0,0 +1,19 @@
+package com.ovidiucristurean.shared.analytics.data.local.database
+
+import androidx.room.Room
+import androidx.room.RoomDatabase
+import okio.Path
+import okio.Path.Companion.toOkioPath
+import java.io.File
+
+fun getAnalyticsDatabaseBuilder(
+    dbFile: File = File(System.getProperty("java.io.tmpdir"), "analytics.db")
+): RoomDatabase.Builder<AnalyticsDatabase> {
+    return Room.databaseBuilder<AnalyticsDatabase>(
+        name = dbFile.absolutePath
+    )
+}
+
+fun getAnalyticsJournalDirectory(
+    directory: File = File(System.getProperty("java.io.tmpdir"), "analytics-journal")
+): Path = directory.toOkioPath()
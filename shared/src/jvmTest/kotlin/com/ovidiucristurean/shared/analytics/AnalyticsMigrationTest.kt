@@ -0,0 +1,155 @@
+package com.ovidiucristurean.shared.analytics
+
+import androidx.room.migration.Migration
+import androidx.room.testing.MigrationTestHelper
+import androidx.sqlite.SQLiteConnection
+import androidx.sqlite.driver.bundled.BundledSQLiteDriver
+import androidx.sqlite.execSQL
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsDatabase
+import com.ovidiucristurean.shared.analytics.data.local.database.MIGRATION_1_2
+import com.ovidiucristurean.shared.analytics.data.local.database.MIGRATION_2_3
+import com.ovidiucristurean.shared.analytics.data.local.database.MIGRATION_3_4
+import com.ovidiucristurean.shared.analytics.data.local.database.MIGRATION_4_5
+import com.ovidiucristurean.shared.analytics.data.local.database.MIGRATION_5_6
+import com.ovidiucristurean.shared.analytics.data.local.database.MIGRATION_6_7
+import com.ovidiucristurean.shared.analytics.data.local.database.MIGRATION_7_8
+import com.ovidiucristurean.shared.analytics.data.local.database.MIGRATION_8_9
+import com.ovidiucristurean.shared.analytics.data.local.database.MIGRATION_9_10
+import org.junit.Rule
+import java.io.File
+import java.nio.file.Path
+import kotlin.test.AfterTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+/**
+ * Runs each migration against a database created from the previous exported schema and lets
+ * [MigrationTestHelper] check the result against the next one.
+ */
+class AnalyticsMigrationTest {
+    private val dbFile = File.createTempFile("analytics-migration", ".db").also { it.delete() }
+
+    // Gradle runs the tests from the module directory, where Room exports the schemas.
+    @get:Rule
+    val helper = MigrationTestHelper(
+        schemaDirectoryPath = Path.of("schemas"),
+        databasePath = dbFile.toPath(),
+        driver = BundledSQLiteDriver(),
+        databaseClass = AnalyticsDatabase::class
+    )
+
+    @AfterTest
+    fun tearDown() {
+        listOf("", "-wal", "-shm", "-journal").forEach { File(dbFile.path + it).delete() }
+    }
+
+    private fun migrate(
+        from: Int,
+        migration: Migration,
+        prepare: SQLiteConnection.() -> Unit = {}
+    ): SQLiteConnection {
+        helper.createDatabase(from).use { it.prepare() }
+        return helper.runMigrationsAndValidate(from + 1, listOf(migration))
+    }
+
+    private fun SQLiteConnection.queryRows(sql: String): List<List<String>> =
+        prepare(sql).use { statement ->
+            buildList {
+                while (statement.step()) {
+                    add(List(statement.getColumnCount()) { statement.getText(it) })
+                }
+            }
+        }
+
+    @Test
+    fun testMigrate1To2() {
+        migrate(1, MIGRATION_1_2) {
+            execSQL("INSERT INTO `visit_events` VALUES ('a', 'shop-1', 100)")
+        }.use { connection ->
+            assertEquals(
+                listOf(listOf("a", "shop-1", "100")),
+                connection.queryRows("SELECT * FROM `visit_events`")
+            )
+        }
+    }
+
+    @Test
+    fun testMigrate2To3NumbersRowsInTimestampOrder() {
+        migrate(2, MIGRATION_2_3) {
+            execSQL("INSERT INTO `visit_events` VALUES ('b', 'shop-1', 200)")
+            execSQL("INSERT INTO `visit_events` VALUES ('a', 'shop-2', 100)")
+        }.use { connection ->
+            assertEquals(
+                listOf(listOf("1", "shop-2", "100"), listOf("2", "shop-1", "200")),
+                connection.queryRows("SELECT * FROM `visit_events` ORDER BY `id`")
+            )
+        }
+    }
+
+    @Test
+    fun testMigrate3To4LeavesTheRollupEmpty() {
+        migrate(3, MIGRATION_3_4) {
+            execSQL(
+                "INSERT INTO `visit_events` (`shopId`, `timestampEpochMillis`) " +
+                    "VALUES ('shop-1', 100)"
+            )
+        }.use { connection ->
+            assertEquals(
+                emptyList(),
+                connection.queryRows("SELECT * FROM `shop_daily_visits`")
+            )
+        }
+    }
+
+    @Test
+    fun testMigrate4To5MovesShopIdsIntoTheDictionary() {
+        migrate(4, MIGRATION_4_5) {
+            execSQL("INSERT INTO `visit_events` VALUES (7, 'shop-1', 100)")
+            execSQL("INSERT INTO `visit_events` VALUES (9, 'shop-2', 200)")
+            execSQL("INSERT INTO `shop_daily_visits` VALUES ('shop-3', 19000, 4)")
+        }.use { connection ->
+            assertEquals(
+                listOf(listOf("7", "shop-1", "100"), listOf("9", "shop-2", "200")),
+                connection.queryRows(
+                    "SELECT v.`id`, d.`externalId`, v.`timestampEpochMillis` " +
+                        "FROM `visit_events` v JOIN `shops_dict` d ON d.`id` = v.`shopKey` " +
+                        "ORDER BY v.`id`"
+                )
+            )
+            assertEquals(
+                listOf(listOf("shop-3", "19000", "4")),
+                connection.queryRows(
+                    "SELECT d.`externalId`, r.`day`, r.`count` " +
+                        "FROM `shop_daily_visits` r JOIN `shops_dict` d ON d.`id` = r.`shopKey`"
+                )
+            )
+        }
+    }
+
+    @Test
+    fun testMigrate5To6() {
+        migrate(5, MIGRATION_5_6).close()
+    }
+
+    @Test
+    fun testMigrate6To7() {
+        migrate(6, MIGRATION_6_7).close()
+    }
+
+    @Test
+    fun testMigrate7To8() {
+        migrate(7, MIGRATION_7_8).close()
+    }
+
+    @Test
+    fun testMigrate8To9() {
+        migrate(8, MIGRATION_8_9).close()
+    }
+
+    @Test
+    fun testMigrate9To10LeavesTheRollupStateEmpty() {
+        migrate(9, MIGRATION_9_10).use { connection ->
+            assertEquals(emptyList(), connection.queryRows("SELECT * FROM `rollup_state`"))
+        }
+    }
+}
@@ -0,0 +1,114 @@
+package com.ovidiucristurean.shared.analytics
+
+import androidx.sqlite.driver.bundled.BundledSQLiteDriver
+import androidx.sqlite.execSQL
+import com.ovidiucristurean.shared.analytics.data.local.database.ANALYTICS_MIGRATIONS
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsDatabase
+import com.ovidiucristurean.shared.analytics.data.local.database.getAnalyticsDatabaseBuilder
+import com.ovidiucristurean.shared.analytics.data.repository.RoomAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.test.runTest
+import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
+import java.io.File
+import kotlin.test.AfterTest
+import kotlin.test.BeforeTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class DailyVisitsRollupTest {
+    private lateinit var dbFile: File
+    private val databases = mutableListOf<AnalyticsDatabase>()
+
+    private val shopId = "test-shop"
+    private val from = Instant.parse("2024-03-01T00:00:00Z")
+    private val to = Instant.parse("2024-03-31T23:59:59.999Z")
+
+    @BeforeTest
+    fun setup() {
+        dbFile = File.createTempFile("analytics-rollup", ".db").also { it.delete() }
+    }
+
+    @AfterTest
+    fun tearDown() {
+        databases.forEach { it.close() }
+        listOf("", "-wal", "-shm", "-journal").forEach { File(dbFile.path + it).delete() }
+    }
+
+    private fun openDatabase(): AnalyticsDatabase = getAnalyticsDatabaseBuilder(dbFile)
+        .setDriver(BundledSQLiteDriver())
+        .addMigrations(*ANALYTICS_MIGRATIONS)
+        .setQueryCoroutineContext(Dispatchers.IO)
+        .build()
+        .also { databases += it }
+
+    // A version 3 database: integer row ids, no rollup yet.
+    private fun createVersion3Database(visits: List<Pair<String, String>>) {
+        BundledSQLiteDriver().open(dbFile.path).apply {
+            execSQL(
+                "CREATE TABLE `visit_events` (" +
+                    "`id` INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, " +
+                    "`shopId` TEXT NOT NULL, " +
+                    "`timestampEpochMillis` INTEGER NOT NULL)"
+            )
+            execSQL(
+                "CREATE INDEX `index_visit_events_shopId_timestampEpochMillis` " +
+                    "ON `visit_events` (`shopId`, `timestampEpochMillis`)"
+            )
+            visits.forEach { (shopId, timestamp) ->
+                execSQL(
+                    "INSERT INTO `visit_events` (`shopId`, `timestampEpochMillis`) " +
+                        "VALUES ('$shopId', ${Instant.parse(timestamp).toEpochMilliseconds()})"
+                )
+            }
+            execSQL("PRAGMA user_version = 3")
+            close()
+        }
+    }
+
+    @Test
+    fun testWriteBeforeFirstReadKeepsMigratedHistory() = runTest {
+        createVersion3Database(
+            listOf(
+                shopId to "2024-03-01T10:00:00Z",
+                shopId to "2024-03-01T11:00:00Z",
+                shopId to "2024-03-02T10:00:00Z",
+            )
+        )
+        val repository = RoomAnalyticsRepository(openDatabase())
+
+        repository.recordVisit(VisitEvent(shopId, Instant.parse("2024-03-20T10:00:00Z")))
+
+        assertEquals(
+            mapOf(
+                LocalDate(2024, 3, 1) to 2,
+                LocalDate(2024, 3, 2) to 1,
+                LocalDate(2024, 3, 20) to 1,
+            ),
+            repository.getDailyVisitCounts(shopId, from, to, TimeZone.UTC)
+        )
+        assertEquals(4, repository.countVisits(shopId, from, to))
+    }
+
+    @Test
+    fun testRollupIsRebuiltWhenTimeZoneChanges() = runTest {
+        val berlin = TimeZone.of("Europe/Berlin")
+        // 23:30 UTC is already the next day in Berlin.
+        RoomAnalyticsRepository(openDatabase(), rollupTimeZone = TimeZone.UTC).recordVisits(
+            listOf(
+                VisitEvent(shopId, Instant.parse("2024-03-01T23:30:00Z")),
+                VisitEvent(shopId, Instant.parse("2024-03-02T10:00:00Z")),
+            )
+        )
+        databases.removeLast().close()
+
+        val repository = RoomAnalyticsRepository(openDatabase(), rollupTimeZone = berlin)
+
+        assertEquals(
+            mapOf(LocalDate(2024, 3, 2) to 2),
+            repository.getDailyVisitCounts(shopId, from, to, berlin)
+        )
+    }
+}
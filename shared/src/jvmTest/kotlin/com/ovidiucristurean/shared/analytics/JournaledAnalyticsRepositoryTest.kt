@@ -0,0 +1,103 @@
+package com.ovidiucristurean.shared.analytics
+
+import androidx.room.Room
+import androidx.sqlite.driver.bundled.BundledSQLiteDriver
+import com.ovidiucristurean.shared.analytics.data.journal.VisitJournal
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsDatabase
+import com.ovidiucristurean.shared.analytics.data.repository.JournaledAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.data.repository.RoomAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.test.runTest
+import kotlinx.datetime.Instant
+import okio.Path.Companion.toPath
+import okio.fakefilesystem.FakeFileSystem
+import kotlin.test.AfterTest
+import kotlin.test.BeforeTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+import kotlin.time.Duration.Companion.minutes
+
+class JournaledAnalyticsRepositoryTest {
+    private val fileSystem = FakeFileSystem()
+    private val directory = "/journal".toPath()
+    private lateinit var database: AnalyticsDatabase
+    private lateinit var room: RoomAnalyticsRepository
+
+    private val shopId = "test-shop"
+    private val baseTime = Instant.parse("2024-01-10T10:00:00Z")
+    private val from = Instant.DISTANT_PAST
+    private val to = Instant.DISTANT_FUTURE
+
+    @BeforeTest
+    fun setup() {
+        database = Room.inMemoryDatabaseBuilder<AnalyticsDatabase>()
+            .setDriver(BundledSQLiteDriver())
+            .setQueryCoroutineContext(Dispatchers.IO)
+            .build()
+        room = RoomAnalyticsRepository(database)
+    }
+
+    @AfterTest
+    fun tearDown() {
+        database.close()
+        fileSystem.checkNoOpenFiles()
+    }
+
+    private fun createJournal() = VisitJournal(fileSystem, directory, maxSegmentRecords = 4)
+
+    // The background drainer never starts, so records only move on reads and explicit drains.
+    private fun createRepository(journal: VisitJournal = createJournal()) =
+        JournaledAnalyticsRepository(
+            room = room,
+            journal = journal,
+            scope = CoroutineScope(Job().apply { cancel() }),
+            ioDispatcher = Dispatchers.IO
+        )
+
+    private fun visits(count: Int, visitorKey: (Int) -> String? = { null }) = List(count) {
+        VisitEvent(shopId, baseTime.plus(it.minutes), visitorKey(it))
+    }
+
+    @Test
+    fun testDrainMovesJournaledVisitsIntoRoom() = runTest {
+        val repository = createRepository()
+        repository.recordVisits(visits(10))
+        assertEquals(0, room.countVisits(shopId, from, to))
+
+        repository.drain()
+
+        assertEquals(10, room.countVisits(shopId, from, to))
+        assertTrue(fileSystem.list(directory).isEmpty())
+    }
+
+    @Test
+    fun testReadsDrainFirst() = runTest {
+        val repository = createRepository()
+        repository.recordVisits(visits(3, visitorKey = { "visitor-${it % 2}" }))
+
+        assertEquals(3, repository.countVisits(shopId, from, to))
+        assertEquals(2, repository.countUniqueVisitors(shopId, baseTime, baseTime.plus(1.minutes)))
+    }
+
+    @Test
+    fun testReplayAfterCrashNeverStoresAVisitTwice() = runTest {
+        // A drain applied the first segment, then the process died before deleting its file.
+        val crashed = createJournal()
+        createRepository(crashed).recordVisits(visits(6))
+        crashed.seal()
+        val (applied, pending) = crashed.sealedSegments()
+        room.applyJournalSegment(applied.id, crashed.read(applied))
+        assertEquals(4, room.countVisits(shopId, from, to))
+
+        val repository = createRepository()
+        repository.drain()
+
+        assertEquals(pending.id, room.getLastAppliedJournalSegment())
+        assertEquals(6, repository.countVisits(shopId, from, to))
+        assertTrue(fileSystem.list(directory).isEmpty())
+    }
+}
@@ -0,0 +1,63 @@
+package com.ovidiucristurean.shared.analytics
+
+import com.ovidiucristurean.shared.analytics.data.memory.VisitColumnStore
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlinx.datetime.Instant
+import java.lang.ref.Reference
+import kotlin.test.Test
+import kotlin.test.assertTrue
+
+/**
+ * Compares the heap retained per visit by a [VisitColumnStore] with the list of [VisitEvent]s
+ * the in-memory repository used to keep.
+ */
+class VisitColumnStoreMemoryTest {
+    private val shopIds = List(10) { "shop-$it" }
+    private val start = Instant.parse("2024-01-01T00:00:00Z").toEpochMilliseconds()
+
+    private fun visits(from: Int, count: Int) = List(count) {
+        val index = from + it
+        VisitEvent(shopIds[index % shopIds.size], Instant.fromEpochMilliseconds(start + index))
+    }
+
+    private fun usedHeap(): Long {
+        val runtime = Runtime.getRuntime()
+        repeat(3) {
+            System.gc()
+            Thread.sleep(50)
+        }
+        return runtime.totalMemory() - runtime.freeMemory()
+    }
+
+    // Only what [build] returns is reachable at the second measurement.
+    private fun retainedBytesPerVisit(build: () -> Any): Double {
+        val before = usedHeap()
+        val retained = build()
+        val after = usedHeap()
+        Reference.reachabilityFence(retained)
+        return (after - before).toDouble() / VISIT_COUNT
+    }
+
+    @Test
+    fun testColumnsRetainFarLessThanVisitObjects() {
+        val eventBytes = retainedBytesPerVisit {
+            ArrayList<VisitEvent>(VISIT_COUNT).apply { addAll(visits(0, VISIT_COUNT)) }
+        }
+        val columnBytes = retainedBytesPerVisit {
+            VisitColumnStore().apply {
+                (0 until VISIT_COUNT step BATCH_SIZE).forEach { appendAll(visits(it, BATCH_SIZE)) }
+            }
+        }
+
+        // About 64 bytes per visit against 12; the margin absorbs GC noise.
+        assertTrue(
+            eventBytes > 4 * columnBytes,
+            "VisitEvent: $eventBytes bytes per visit, columns: $columnBytes"
+        )
+    }
+
+    private companion object {
+        const val VISIT_COUNT = 1_000_000
+        const val BATCH_SIZE = 10_000
+    }
+}
@@ -0,0 +1,98 @@
+package com.ovidiucristurean.shared.analytics
+
+import androidx.sqlite.driver.bundled.BundledSQLiteDriver
+import com.ovidiucristurean.shared.analytics.data.local.dao.VisitEventDao
+import com.ovidiucristurean.shared.analytics.data.local.database.ANALYTICS_MIGRATIONS
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsDatabase
+import com.ovidiucristurean.shared.analytics.data.local.database.getAnalyticsDatabaseBuilder
+import com.ovidiucristurean.shared.analytics.data.local.entity.VisitEventEntity
+import com.ovidiucristurean.shared.analytics.data.local.model.DailyVisitCount
+import com.ovidiucristurean.shared.analytics.data.local.model.HourOfWeekVisitCount
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.test.runTest
+import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import java.io.File
+import kotlin.test.AfterTest
+import kotlin.test.BeforeTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class VisitEventDaoTest {
+    private lateinit var dbFile: File
+    private lateinit var database: AnalyticsDatabase
+    private lateinit var dao: VisitEventDao
+
+    private val shopKey = 1L
+    private val hour = 3_600_000L
+
+    @BeforeTest
+    fun setup() {
+        dbFile = File.createTempFile("analytics-dao", ".db").also { it.delete() }
+        database = getAnalyticsDatabaseBuilder(dbFile)
+            .setDriver(BundledSQLiteDriver())
+            .addMigrations(*ANALYTICS_MIGRATIONS)
+            .setQueryCoroutineContext(Dispatchers.IO)
+            .build()
+        dao = database.visitEventDao()
+    }
+
+    @AfterTest
+    fun tearDown() {
+        database.close()
+        listOf("", "-wal", "-shm", "-journal").forEach { File(dbFile.path + it).delete() }
+    }
+
+    private suspend fun insertVisits(vararg timestamps: String) {
+        dao.insertAll(
+            timestamps.map {
+                VisitEventEntity(
+                    shopKey = shopKey,
+                    timestampEpochMillis = Instant.parse(it).toEpochMilliseconds()
+                )
+            }
+        )
+    }
+
+    private fun epochDayOf(date: LocalDate) = date.toEpochDays().toLong()
+
+    @Test
+    fun testDaysBefore1970AreFloored() = runTest {
+        // In UTC+01:00 the first visit is still on 1969-12-31 and the second is on 1970-01-01.
+        insertVisits("1969-12-31T10:00:00Z", "1969-12-31T23:30:00Z")
+        val from = Instant.parse("1969-12-01T00:00:00Z").toEpochMilliseconds()
+        val to = Instant.parse("1970-01-31T00:00:00Z").toEpochMilliseconds()
+
+        assertEquals(
+            listOf(
+                DailyVisitCount(epochDayOf(LocalDate(1969, 12, 31)), 1),
+                DailyVisitCount(epochDayOf(LocalDate(1970, 1, 1)), 1),
+            ),
+            dao.countVisitsPerDay(shopKey, from, to, offsetMillis = hour)
+                .sortedBy { it.epochDay }
+        )
+        assertEquals(
+            listOf(epochDayOf(LocalDate(1969, 12, 31)) to 2),
+            dao.aggregateDailyVisits(from, to, offsetMillis = 0).map { it.day to it.count }
+        )
+        assertEquals(
+            listOf(epochDayOf(LocalDate(1969, 12, 31)) to 2),
+            dao.countVisitsPerDayForShops(listOf(shopKey), from, to, offsetMillis = 0)
+                .map { it.day to it.count }
+        )
+    }
+
+    @Test
+    fun testHoursOfWeekBefore1970AreNotNegative() = runTest {
+        // In UTC+01:00 these are Wednesday 1969-12-31 11:30 and Monday 1969-12-29 00:00.
+        insertVisits("1969-12-31T10:30:00Z", "1969-12-28T23:00:00Z")
+        val from = Instant.parse("1969-12-01T00:00:00Z").toEpochMilliseconds()
+        val to = Instant.parse("1970-01-31T00:00:00Z").toEpochMilliseconds()
+
+        assertEquals(
+            listOf(HourOfWeekVisitCount(0, 1), HourOfWeekVisitCount(2 * 24 + 11, 1)),
+            dao.countVisitsPerHourOfWeek(shopKey, from, to, offsetMillis = hour)
+                .sortedBy { it.hourOfWeek }
+        )
+    }
+}
@@ -0,0 +1,205 @@
+package com.ovidiucristurean.shared.analytics
+
+import androidx.sqlite.driver.bundled.BundledSQLiteDriver
+import com.ovidiucristurean.shared.analytics.data.local.database.ANALYTICS_MIGRATIONS
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsDatabase
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsStorageProfile
+import com.ovidiucristurean.shared.analytics.data.local.database.getAnalyticsDatabaseBuilder
+import com.ovidiucristurean.shared.analytics.data.local.database.setStorageProfile
+import com.ovidiucristurean.shared.analytics.data.repository.RoomAnalyticsRepository
+import com.ovidiucristurean.shared.analytics.data.retention.VisitRetentionEngine
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import com.ovidiucristurean.shared.analytics.domain.usecase.GetShopStatisticsUseCase
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.test.runTest
+import kotlinx.datetime.Clock
+import kotlinx.datetime.DateTimeUnit
+import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
+import kotlinx.datetime.atStartOfDayIn
+import kotlinx.datetime.atTime
+import kotlinx.datetime.plus
+import kotlinx.datetime.toInstant
+import java.io.File
+import kotlin.test.AfterTest
+import kotlin.test.BeforeTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+import kotlin.time.Duration.Companion.days
+import kotlin.time.Duration.Companion.seconds
+
+class VisitRetentionTest {
+    private lateinit var dbFile: File
+    private lateinit var database: AnalyticsDatabase
+    private lateinit var repository: RoomAnalyticsRepository
+
+    private val shopId = "test-shop"
+    private val firstDay = LocalDate(2024, 1, 1)
+    private val lastDay = LocalDate(2024, 5, 31)
+    private val clock = object : Clock {
+        override fun now(): Instant = Instant.parse("2024-06-01T12:00:00Z")
+    }
+
+    @BeforeTest
+    fun setup() {
+        dbFile = File.createTempFile("analytics-retention", ".db").also { it.delete() }
+        database = getAnalyticsDatabaseBuilder(dbFile)
+            .setDriver(BundledSQLiteDriver())
+            .addMigrations(*ANALYTICS_MIGRATIONS)
+            .setQueryCoroutineContext(Dispatchers.IO)
+            .build()
+        repository = RoomAnalyticsRepository(database)
+    }
+
+    @AfterTest
+    fun tearDown() {
+        database.close()
+        listOf("", "-wal", "-shm", "-journal").forEach { File(dbFile.path + it).delete() }
+    }
+
+    private fun createEngine(
+        repository: RoomAnalyticsRepository = this.repository
+    ) = VisitRetentionEngine(
+        database = database,
+        repository = repository,
+        rawWindow = 90.days,
+        chunkSize = 50,
+        clock = clock
+    )
+
+    // Two visits a day, at 06:00 and 18:00 UTC.
+    private suspend fun recordTwoVisitsPerDay() {
+        var day = firstDay
+        val visits = mutableListOf<VisitEvent>()
+        while (day <= lastDay) {
+            visits += VisitEvent(shopId, day.atTime(6, 0).toInstant(TimeZone.UTC))
+            visits += VisitEvent(shopId, day.atTime(18, 0).toInstant(TimeZone.UTC))
+            day = day.plus(1, DateTimeUnit.DAY)
+        }
+        repository.recordVisits(visits)
+    }
+
+    private fun startOf(date: LocalDate) = date.atStartOfDayIn(TimeZone.UTC)
+
+    @Test
+    fun testOldRawVisitsAreDeletedAndStatisticsAreKept() = runTest {
+        recordTwoVisitsPerDay()
+        val from = startOf(firstDay)
+        val to = Instant.parse("2024-05-31T23:59:59.999Z")
+        val berlin = TimeZone.of("Europe/Berlin")
+        val getStatistics = GetShopStatisticsUseCase(repository)
+
+        val statisticsBefore = getStatistics(shopId, from, to)
+        val berlinDailyBefore = repository.getDailyVisitCounts(shopId, from, to, berlin)
+
+        val report = createEngine().run()
+
+        val horizon = startOf(LocalDate(2024, 3, 3))
+        assertEquals(horizon, report.rawHorizon)
+        assertEquals(2 * 62, report.deletedVisits)
+        assertTrue(repository.getVisits(shopId, from, horizon).isEmpty())
+        assertEquals(2, repository.getVisits(shopId, horizon, horizon + 1.days).size)
+
+        assertEquals(statisticsBefore, GetShopStatisticsUseCase(repository)(shopId, from, to))
+        assertEquals(berlinDailyBefore, repository.getDailyVisitCounts(shopId, from, to, berlin))
+        assertEquals(statisticsBefore.totalVisits, repository.countVisits(shopId, from, to))
+    }
+
+    @Test
+    fun testPartialDaysBeforeHorizonAreRoundedOut() = runTest {
+        recordTwoVisitsPerDay()
+        val from = Instant.parse("2024-02-10T12:00:00Z")
+        val to = Instant.parse("2024-04-10T12:00:00Z")
+        assertEquals(2 * 60, repository.countVisits(shopId, from, to))
+
+        createEngine().run()
+
+        // 2024-02-10 now counts as a whole day; the partial day after the horizon is still exact.
+        assertEquals(2 * 60 + 1, repository.countVisits(shopId, from, to))
+    }
+
+    @Test
+    fun testRunIsIdempotent() = runTest {
+        recordTwoVisitsPerDay()
+        val engine = createEngine()
+
+        val first = engine.run()
+        val second = engine.run()
+
+        assertEquals(first.rawHorizon, second.rawHorizon)
+        assertEquals(0, second.deletedVisits)
+    }
+
+    @Test
+    fun testRebuildKeepsDaysBeforeHorizon() = runTest {
+        recordTwoVisitsPerDay()
+        createEngine().run()
+
+        repository.rebuildDailyVisits()
+
+        val from = startOf(firstDay)
+        val to = startOf(lastDay.plus(1, DateTimeUnit.DAY))
+        assertEquals(2 * 152, repository.countVisits(shopId, from, to))
+    }
+
+    @Test
+    fun testRebuildInAZoneWestOfTheRollupKeepsEveryVisit() = runTest {
+        recordTwoVisitsPerDay()
+        createEngine().run()
+        val from = startOf(firstDay)
+        val to = startOf(lastDay.plus(1, DateTimeUnit.DAY))
+        val newYork = TimeZone.of("America/New_York")
+
+        // The UTC horizon is 19:00 the day before in New York, whose rollup row must survive.
+        val reopened = RoomAnalyticsRepository(database, rollupTimeZone = newYork)
+
+        assertEquals(2 * 152, reopened.countVisits(shopId, from, to))
+        assertEquals(2 * 152, reopened.getDailyVisitCounts(shopId, from, to, newYork).values.sum())
+        createEngine(reopened).run()
+        assertEquals(2 * 152, reopened.countVisits(shopId, from, to))
+    }
+
+    @Test
+    fun testRunLeavesLegacyDatabasesToAnExplicitVacuum() = runTest {
+        recordTwoVisitsPerDay()
+        val engine = createEngine()
+
+        assertEquals(0, engine.run().freedPages)
+        assertTrue(engine.enableIncrementalVacuum())
+        assertFalse(engine.enableIncrementalVacuum())
+    }
+
+    @Test
+    fun testStorageProfileDatabasesReclaimPurgedPages() = runTest {
+        database.close()
+        database = getAnalyticsDatabaseBuilder(dbFile)
+            .setStorageProfile(AnalyticsStorageProfile.LOW_MEMORY)
+            .addMigrations(*ANALYTICS_MIGRATIONS)
+            .setQueryCoroutineContext(Dispatchers.IO)
+            .build()
+        repository = RoomAnalyticsRepository(database)
+        val start = startOf(firstDay)
+        repository.recordVisits(List(20_000) { VisitEvent(shopId, start + (it * 300).seconds) })
+        val engine = createEngine()
+
+        assertFalse(engine.enableIncrementalVacuum())
+        assertTrue(engine.run().freedPages > 0)
+    }
+
+    @Test
+    fun testPurgeStopsWhenRollupIsMissingVisits() = runTest {
+        recordTwoVisitsPerDay()
+        val shopKey = repository.getOrCreateShopKeys(setOf(shopId)).getValue(shopId)
+        database.visitEventDao()
+            .incrementDailyVisits(shopKey, firstDay.toEpochDays().toLong(), delta = -1)
+
+        val report = createEngine().run()
+
+        val from = startOf(firstDay)
+        assertEquals(0, report.deletedVisits)
+        assertEquals(2, repository.getVisits(shopId, from, from + 1.days).size)
+    }
+}
@@ -0,0 +1,46 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.data.repository.InMemoryAnalyticsRepository
+import kotlinx.coroutines.test.runTest
+import kotlinx.datetime.Instant
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNotEquals
+import kotlin.test.assertTrue
+
+class TrackerReplayTest {
+    private fun generate(seed: Long, count: Int = 5_000) =
+        VisitStreamGenerator(seed = seed).generate(BENCHMARK_START).take(count).toList()
+
+    @Test
+    fun testSameSeedGivesSameStream() {
+        assertEquals(generate(seed = 7), generate(seed = 7))
+        assertNotEquals(generate(seed = 7), generate(seed = 8))
+    }
+
+    @Test
+    fun testTimestampsStrictlyIncrease() {
+        generate(seed = 7).zipWithNext().forEach { (previous, next) ->
+            assertTrue(next.timestamp > previous.timestamp)
+        }
+    }
+
+    @Test
+    fun testReplayReportsEveryCommittedVisit() = runTest {
+        val events = generate(seed = 42, count = 2_000)
+        val repository = InMemoryAnalyticsRepository()
+
+        val report = TrackerReplay(events, eventsPerSecond = 0.0).run(repository)
+
+        assertEquals(events.size, report.tracked)
+        assertEquals(events.size, report.committed)
+        assertTrue(report.eventsPerSecond > 0)
+        assertTrue(report.p50Latency <= report.p99Latency)
+        assertEquals(
+            events.size,
+            events.map { it.shopId }.distinct().sumOf {
+                repository.countVisits(it, Instant.DISTANT_PAST, Instant.DISTANT_FUTURE)
+            }
+        )
+    }
+}
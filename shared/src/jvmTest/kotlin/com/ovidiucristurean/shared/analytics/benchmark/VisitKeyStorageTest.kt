@@ -0,0 +1,27 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.domain.model.VisitEvent
+import kotlin.test.Test
+import kotlin.test.assertTrue
+import kotlin.time.Duration.Companion.seconds
+
+class VisitKeyStorageTest {
+    private val events = List(20_000) {
+        VisitEvent(benchmarkShopId(it), BENCHMARK_START + it.seconds)
+    }
+
+    private fun sizeBytes(key: VisitKey): Long = RawVisitTable(key).use { table ->
+        events.chunked(1_000).forEach { table.insert(it) }
+        table.sizeBytes()
+    }
+
+    // A TEXT primary key needs its own index next to the table, with a 36-byte key in each row of
+    // both. The rowid key is stored once, as a varint.
+    @Test
+    fun testIntegerKeyTakesLessSpaceThanUuidKey() {
+        val uuid = sizeBytes(VisitKey.UUID)
+        val integer = sizeBytes(VisitKey.INTEGER)
+
+        assertTrue(integer * 3 < uuid * 2, "integer key: $integer bytes, uuid key: $uuid bytes")
+    }
+}
@@ -0,0 +1,5 @@
+package com.ovidiucristurean.shared.analytics
+
+actual fun logMessage(message: String) {
+    println("LINUX_TO_KMP_APP - $message")
+}
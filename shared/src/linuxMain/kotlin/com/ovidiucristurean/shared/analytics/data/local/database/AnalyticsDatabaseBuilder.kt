@@ -0,0 +1,18 @@
+package com.ovidiucristurean.shared.analytics.data.local.database
+
+import androidx.room.Room
+import androidx.room.RoomDatabase
+import okio.Path
+import okio.Path.Companion.toPath
+
+fun getAnalyticsDatabaseBuilder(
+    dbFile: String = "analytics.db"
+): RoomDatabase.Builder<AnalyticsDatabase> {
+    return Room.databaseBuilder<AnalyticsDatabase>(
+        name = dbFile
+    )
+}
+
+fun getAnalyticsJournalDirectory(
+    directory: String = "analytics-journal"
+): Path = directory.toPath()
@@ -0,0 +1,28 @@
+package com.ovidiucristurean.shared.analytics.benchmark
+
+import com.ovidiucristurean.shared.analytics.data.local.database.ANALYTICS_MIGRATIONS
+import com.ovidiucristurean.shared.analytics.data.local.database.AnalyticsStorageProfile
+import com.ovidiucristurean.shared.analytics.data.local.database.getAnalyticsDatabaseBuilder
+import com.ovidiucristurean.shared.analytics.data.local.database.setStorageProfile
+import kotlinx.cinterop.ExperimentalForeignApi
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.IO
+import okio.Path.Companion.toPath
+import platform.posix.getpid
+import platform.posix.unlink
+import kotlin.random.Random
+
+@OptIn(ExperimentalForeignApi::class)
+internal actual fun createBenchmarkDatabase(
+    profile: AnalyticsStorageProfile
+): BenchmarkDatabase {
+    val dbFile = "/tmp/analytics-benchmark-${getpid()}-${Random.nextLong().toULong()}.db"
+    val database = getAnalyticsDatabaseBuilder(dbFile)
+        .setStorageProfile(profile)
+        .addMigrations(*ANALYTICS_MIGRATIONS)
+        .setQueryCoroutineContext(Dispatchers.IO)
+        .build()
+    return BenchmarkDatabase(database, "$dbFile-journal".toPath()) {
+        listOf("", "-wal", "-shm", "-journal").forEach { unlink(dbFile + it) }
+    }
+}